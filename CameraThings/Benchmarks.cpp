@@ -0,0 +1,147 @@
+﻿#include "Benchmarks.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <glm/geometric.hpp>
+
+#include "Bvh.h"
+#include "Collision.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double SecondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    /// \brief Random unit-ish boxes at a constant density, so every size sees similar query results
+    std::vector<Aabb> RandomBoxes(size_t count, float& worldSize, std::mt19937& rng)
+    {
+        worldSize = 3.0f * std::cbrt(static_cast<float>(count));
+        std::uniform_real_distribution<float> position(0.0f, worldSize);
+        std::uniform_real_distribution<float> size(0.1f, 1.0f);
+
+        std::vector<Aabb> boxes(count);
+        for (Aabb& box : boxes)
+        {
+            glm::vec3 p(position(rng), position(rng), position(rng));
+            box.min = p;
+            box.max = p + glm::vec3(size(rng), size(rng), size(rng));
+        }
+        return boxes;
+    }
+}
+
+void Benchmarks::RunBvh()
+{
+    const size_t sizes[] = { 10000, 100000, 1000000 };
+    const int queryCount = 200000;
+
+    std::mt19937 rng(1234);
+    for (size_t count : sizes)
+    {
+        float worldSize;
+        std::vector<Aabb> boxes = RandomBoxes(count, worldSize, rng);
+
+        Bvh bvh;
+        Clock::time_point start = Clock::now();
+        bvh.Build(boxes);
+        double buildTime = SecondsSince(start);
+
+        std::uniform_real_distribution<float> position(0.0f, worldSize);
+        std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+
+        std::vector<uint32_t> hits;
+        size_t sphereHits = 0;
+        start = Clock::now();
+        for (int i = 0; i < queryCount; i++)
+        {
+            Sphere sphere;
+            sphere.center = glm::vec3(position(rng), position(rng), position(rng));
+            sphere.radius = 2.0f;
+            hits.clear();
+            bvh.QuerySphere(sphere, hits);
+            sphereHits += hits.size();
+        }
+        double sphereTime = SecondsSince(start);
+
+        size_t rayHits = 0;
+        start = Clock::now();
+        for (int i = 0; i < queryCount; i++)
+        {
+            Ray ray;
+            ray.origin = glm::vec3(position(rng), position(rng), position(rng));
+            ray.direction = glm::normalize(glm::vec3(direction(rng), direction(rng), direction(rng)) + glm::vec3(1e-4f));
+            BvhRayHit hit;
+            if (bvh.Raycast(ray, worldSize, hit))
+                rayHits++;
+        }
+        double rayTime = SecondsSince(start);
+
+        std::cout << "BVH " << count << " primitives, " << bvh.GetNodes().size() << " nodes, build "
+                  << buildTime * 1000.0 << " ms\n"
+                  << "  sphere queries/s: " << queryCount / sphereTime << " (avg hits " << double(sphereHits) / queryCount << ")\n"
+                  << "  ray queries/s:    " << queryCount / rayTime << " (hit rate " << double(rayHits) / queryCount << ")" << std::endl;
+    }
+}
+
+void Benchmarks::RunBroadPhase(const std::vector<BroadPhaseType>& types)
+{
+    const size_t sizes[] = { 1000, 10000, 50000 };
+    const int stepCount = 300;
+
+    for (size_t count : sizes)
+    {
+        for (BroadPhaseType type : types)
+        {
+            // same seed for every implementation so they see the same scene
+            std::mt19937 rng(42);
+            const float worldSize = 4.0f * std::cbrt(static_cast<float>(count));
+            std::uniform_real_distribution<float> position(0.0f, worldSize);
+            std::uniform_real_distribution<float> velocity(-0.05f, 0.05f);
+
+            std::vector<Sphere> spheres(count);
+            std::vector<glm::vec3> velocities(count);
+            for (size_t i = 0; i < count; i++)
+            {
+                spheres[i].center = glm::vec3(position(rng), position(rng), position(rng));
+                spheres[i].radius = 0.5f;
+                velocities[i] = glm::vec3(velocity(rng), velocity(rng), velocity(rng));
+            }
+
+            std::unique_ptr<BroadPhase> broadPhase = BroadPhase::Create(type);
+            std::vector<Aabb> bounds(count);
+            size_t totalPairs = 0;
+            double totalTime = 0.0;
+            for (int step = 0; step < stepCount; step++)
+            {
+                for (size_t i = 0; i < count; i++)
+                {
+                    Sphere& s = spheres[i];
+                    s.center += velocities[i];
+                    for (int axis = 0; axis < 3; axis++)
+                    {
+                        if (s.center[axis] < 0.0f || s.center[axis] > worldSize)
+                            velocities[i][axis] = -velocities[i][axis];
+                    }
+                    bounds[i].min = s.center - glm::vec3(s.radius);
+                    bounds[i].max = s.center + glm::vec3(s.radius);
+                }
+
+                Clock::time_point start = Clock::now();
+                broadPhase->Update(bounds);
+                totalTime += SecondsSince(start);
+                totalPairs += broadPhase->GetPairs().size();
+            }
+
+            std::cout << "Broad phase " << broadPhase->GetName() << ", " << count << " objects: "
+                      << totalTime * 1000.0 / stepCount << " ms/step, "
+                      << double(totalPairs) / stepCount << " pairs/step" << std::endl;
+        }
+    }
+}
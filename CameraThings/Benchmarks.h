@@ -0,0 +1,15 @@
+﻿#pragma once
+#include <vector>
+
+#include "BroadPhase.h"
+
+// Stand-alone micro benchmarks, started from the command line (see main in CameraThings.cpp)
+namespace Benchmarks
+{
+    /// \brief Build time and sphere/ray queries per second for 10k, 100k and 1M static boxes
+    void RunBvh();
+
+    /// \brief Steps the same scene of moving spheres through each broad phase and reports ms per step
+    /// \param types the implementations to compare
+    void RunBroadPhase(const std::vector<BroadPhaseType>& types);
+}
@@ -0,0 +1,38 @@
+﻿#include "BroadPhase.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "SweepAndPrune.h"
+#include "UniformGrid.h"
+
+std::unique_ptr<BroadPhase> BroadPhase::Create(BroadPhaseType type)
+{
+    switch (type)
+    {
+    case BroadPhaseType::SweepAndPrune:
+        return std::unique_ptr<BroadPhase>(new SweepAndPrune());
+    case BroadPhaseType::Grid:
+    default:
+        return std::unique_ptr<BroadPhase>(new UniformGrid());
+    }
+}
+
+bool BroadPhase::ParseType(const char* name, BroadPhaseType& type)
+{
+    if (std::strcmp(name, "grid") == 0)
+        type = BroadPhaseType::Grid;
+    else if (std::strcmp(name, "sap") == 0)
+        type = BroadPhaseType::SweepAndPrune;
+    else
+        return false;
+    return true;
+}
+
+void BroadPhase::SortPairs()
+{
+    std::sort(pairs.begin(), pairs.end(), [](const CollisionPair& l, const CollisionPair& r)
+    {
+        return l.a != r.a ? l.a < r.a : l.b < r.b;
+    });
+}
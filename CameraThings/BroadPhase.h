@@ -0,0 +1,39 @@
+﻿#pragma once
+#include <memory>
+#include <vector>
+
+#include "Collision.h"
+
+enum class BroadPhaseType
+{
+    Grid,
+    SweepAndPrune
+};
+
+/// \brief Finds pairs of moving objects whose boxes overlap. The pairs are handed to the
+/// exact tests in NarrowPhase. Implementations are interchangeable at runtime so they can
+/// be compared on the same scene.
+class BroadPhase
+{
+public:
+    virtual ~BroadPhase() = default;
+
+    /// \brief Updates with the current box of every object. Objects keep their index between
+    /// calls; a change in object count starts over from scratch.
+    virtual void Update(const std::vector<Aabb>& bounds) = 0;
+    virtual const char* GetName() const = 0;
+
+    /// \brief Overlapping pairs from the last Update, sorted by (a, b) so results do not
+    /// depend on the implementation
+    const std::vector<CollisionPair>& GetPairs() const { return pairs; }
+
+    static std::unique_ptr<BroadPhase> Create(BroadPhaseType type);
+
+    /// \brief Parses "grid" or "sap"
+    static bool ParseType(const char* name, BroadPhaseType& type);
+
+protected:
+    std::vector<CollisionPair> pairs;
+
+    void SortPairs();
+};
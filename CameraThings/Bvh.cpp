@@ -0,0 +1,238 @@
+﻿#include "Bvh.h"
+
+#include <algorithm>
+#include <numeric>
+#include <glm/common.hpp>
+
+namespace
+{
+    const uint32_t MaxLeafSize = 4;
+    const uint32_t MaxForcedLeafSize = 16; // leaves can grow this big if splitting costs more
+    const int BinCount = 12;
+    const int MaxDepth = 60;               // keeps the fixed traversal stacks below safe
+    const int StackSize = 64;
+
+    struct Bin
+    {
+        Aabb bounds;
+        uint32_t count = 0;
+    };
+}
+
+/// \brief Builds the flattened hierarchy. Primitive boxes are copied in leaf order so a
+/// leaf's primitives sit next to each other in memory during queries.
+/// \param primitiveBounds one box per primitive
+void Bvh::Build(const std::vector<Aabb>& primitiveBounds)
+{
+    nodes.clear();
+    primBounds = primitiveBounds;
+    primIndices.resize(primitiveBounds.size());
+    std::iota(primIndices.begin(), primIndices.end(), 0u);
+    if (primitiveBounds.empty())
+        return;
+
+    std::vector<glm::vec3> centers(primitiveBounds.size());
+    for (size_t i = 0; i < primitiveBounds.size(); i++)
+        centers[i] = primitiveBounds[i].Center();
+
+    nodes.reserve(2 * primitiveBounds.size() / MaxLeafSize + 1);
+    BuildRecursive(centers, 0, static_cast<uint32_t>(primitiveBounds.size()), 0);
+
+    for (size_t i = 0; i < primIndices.size(); i++)
+        primBounds[i] = primitiveBounds[primIndices[i]];
+}
+
+uint32_t Bvh::BuildRecursive(const std::vector<glm::vec3>& centers, uint32_t first, uint32_t count, int depth)
+{
+    uint32_t index = static_cast<uint32_t>(nodes.size());
+    nodes.push_back(BvhNode());
+
+    Aabb bounds;
+    Aabb centerBounds;
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        bounds.Grow(primBounds[primIndices[i]]);
+        centerBounds.Grow(centers[primIndices[i]]);
+    }
+    nodes[index].bounds = bounds;
+
+    auto makeLeaf = [&]()
+    {
+        nodes[index].offset = first;
+        nodes[index].count = static_cast<uint16_t>(count);
+        nodes[index].axis = 0;
+        return index;
+    };
+
+    if (count <= MaxLeafSize || depth >= MaxDepth)
+        return makeLeaf();
+
+    // binned surface area heuristic over all three axes
+    int bestAxis = -1;
+    int bestSplit = 0;
+    float bestCost = 1e30f;
+    glm::vec3 extent = centerBounds.max - centerBounds.min;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        if (extent[axis] <= 0.0f)
+            continue;
+
+        Bin bins[BinCount];
+        float scale = BinCount / extent[axis];
+        for (uint32_t i = first; i < first + count; i++)
+        {
+            uint32_t prim = primIndices[i];
+            int b = std::min(BinCount - 1, static_cast<int>((centers[prim][axis] - centerBounds.min[axis]) * scale));
+            bins[b].count++;
+            bins[b].bounds.Grow(primBounds[prim]);
+        }
+
+        float rightArea[BinCount];
+        uint32_t rightCount[BinCount];
+        Aabb accumulated;
+        uint32_t accumulatedCount = 0;
+        for (int b = BinCount - 1; b > 0; b--)
+        {
+            accumulated.Grow(bins[b].bounds);
+            accumulatedCount += bins[b].count;
+            rightArea[b] = accumulatedCount ? accumulated.SurfaceArea() : 0.0f;
+            rightCount[b] = accumulatedCount;
+        }
+
+        accumulated = Aabb();
+        accumulatedCount = 0;
+        for (int b = 1; b < BinCount; b++)
+        {
+            accumulated.Grow(bins[b - 1].bounds);
+            accumulatedCount += bins[b - 1].count;
+            if (accumulatedCount == 0 || rightCount[b] == 0)
+                continue;
+            float cost = accumulated.SurfaceArea() * accumulatedCount + rightArea[b] * rightCount[b];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = b;
+            }
+        }
+    }
+
+    uint32_t* begin = primIndices.data() + first;
+    uint32_t* end = begin + count;
+    uint32_t* middle = begin;
+    if (bestAxis >= 0)
+    {
+        // a leaf costs one test per primitive against the node's whole area
+        if (count <= MaxForcedLeafSize && bestCost >= bounds.SurfaceArea() * count)
+            return makeLeaf();
+
+        float scale = BinCount / extent[bestAxis];
+        float minimum = centerBounds.min[bestAxis];
+        middle = std::partition(begin, end, [&](uint32_t prim)
+        {
+            int b = std::min(BinCount - 1, static_cast<int>((centers[prim][bestAxis] - minimum) * scale));
+            return b < bestSplit;
+        });
+    }
+
+    if (middle == begin || middle == end)
+    {
+        // all centres coincide (or rounding put everything on one side): split by count
+        bestAxis = std::max(bestAxis, 0);
+        middle = begin + count / 2;
+        std::nth_element(begin, middle, end, [&](uint32_t a, uint32_t b)
+        {
+            return centers[a][bestAxis] < centers[b][bestAxis];
+        });
+    }
+
+    uint32_t leftCount = static_cast<uint32_t>(middle - begin);
+    BuildRecursive(centers, first, leftCount, depth + 1);
+    uint32_t right = BuildRecursive(centers, first + leftCount, count - leftCount, depth + 1);
+
+    nodes[index].offset = right;
+    nodes[index].count = 0;
+    nodes[index].axis = static_cast<uint16_t>(bestAxis);
+    return index;
+}
+
+void Bvh::QuerySphere(const Sphere& sphere, std::vector<uint32_t>& hits) const
+{
+    if (nodes.empty())
+        return;
+
+    uint32_t stack[StackSize];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        uint32_t index = stack[--top];
+        const BvhNode& node = nodes[index];
+        if (!Collision::SphereOverlapsAabb(sphere, node.bounds))
+            continue;
+
+        if (node.count > 0)
+        {
+            for (uint32_t i = node.offset; i < node.offset + node.count; i++)
+            {
+                if (Collision::SphereOverlapsAabb(sphere, primBounds[i]))
+                    hits.push_back(primIndices[i]);
+            }
+            continue;
+        }
+
+        stack[top++] = node.offset;
+        stack[top++] = index + 1;
+    }
+}
+
+bool Bvh::Raycast(const Ray& ray, float maxT, BvhRayHit& hit) const
+{
+    if (nodes.empty())
+        return false;
+
+    glm::vec3 invDirection = 1.0f / ray.direction;
+    float closest = maxT;
+    bool found = false;
+
+    uint32_t stack[StackSize];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        uint32_t index = stack[--top];
+        const BvhNode& node = nodes[index];
+        float tNear;
+        if (!Collision::RayHitsAabb(ray, invDirection, node.bounds, closest, tNear))
+            continue;
+
+        if (node.count > 0)
+        {
+            for (uint32_t i = node.offset; i < node.offset + node.count; i++)
+            {
+                float t;
+                if (Collision::RayHitsAabb(ray, invDirection, primBounds[i], closest, t))
+                {
+                    closest = t;
+                    hit.primitive = primIndices[i];
+                    hit.t = t;
+                    found = true;
+                }
+            }
+            continue;
+        }
+
+        // push the far child first so the near one is popped next and shrinks closest early
+        if (ray.direction[node.axis] < 0.0f)
+        {
+            stack[top++] = index + 1;
+            stack[top++] = node.offset;
+        }
+        else
+        {
+            stack[top++] = node.offset;
+            stack[top++] = index + 1;
+        }
+    }
+    return found;
+}
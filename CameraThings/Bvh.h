@@ -0,0 +1,48 @@
+﻿#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Collision.h"
+
+/// \brief One node of the flattened hierarchy, 32 bytes so two fit in a cache line.
+/// Interior nodes keep their left child directly after themselves and store the index
+/// of the right child in offset. Leaves store the first entry in primIndices instead.
+struct BvhNode
+{
+    Aabb bounds;
+    uint32_t offset;
+    uint16_t count; // 0 for interior nodes
+    uint16_t axis;  // split axis, used to visit the nearer child first for rays
+};
+
+struct BvhRayHit
+{
+    uint32_t primitive = UINT32_MAX;
+    float t = 0.0f;
+};
+
+/// \brief Bounding volume hierarchy for static geometry (Kube objects, imported meshes).
+/// Built once with the surface area heuristic and never refitted.
+class Bvh
+{
+public:
+    /// \brief Builds the hierarchy over one box per primitive. Primitive ids in query
+    /// results are indices into this vector.
+    void Build(const std::vector<Aabb>& primitiveBounds);
+
+    /// \brief Appends every primitive whose box overlaps the sphere to hits
+    void QuerySphere(const Sphere& sphere, std::vector<uint32_t>& hits) const;
+
+    /// \brief Finds the nearest primitive box hit by the ray within maxT
+    bool Raycast(const Ray& ray, float maxT, BvhRayHit& hit) const;
+
+    const std::vector<BvhNode>& GetNodes() const { return nodes; }
+    size_t GetPrimitiveCount() const { return primBounds.size(); }
+
+private:
+    std::vector<BvhNode> nodes;
+    std::vector<uint32_t> primIndices;
+    std::vector<Aabb> primBounds;
+
+    uint32_t BuildRecursive(const std::vector<glm::vec3>& centers, uint32_t first, uint32_t count, int depth);
+};
@@ -1,16 +1,217 @@
 ﻿#include "Camera.h"
 
+#include <algorithm>
+#include <cmath>
+#include <glm/trigonometric.hpp>
+#include <glm/ext/matrix_transform.hpp>
+
+void Camera::SetMode(CameraMode mode)
+{
+    if (mode == this->mode)
+        return;
+    this->mode = mode;
+
+    if (mode == CameraMode::Orbit)
+    {
+        // turn towards the target from where we are, keeping the current distance
+        glm::vec3 toTarget = orbitTarget - cameraPos;
+        float distance = glm::length(toTarget);
+        if (distance > 1e-4f)
+        {
+            goalOrientation = glm::quatLookAt(toTarget / distance, worldUp);
+            goalDistance = distance;
+            orbitDistance = distance;
+            pitch = PitchOf(goalOrientation);
+        }
+    }
+    else
+    {
+        goalPos = cameraPos;
+    }
+}
+
+void Camera::SetPosition(const glm::vec3& position)
+{
+    goalPos = position;
+    if (position == cameraPos)
+        return;
+    cameraPos = position;
+    viewDirty = true;
+}
+
+void Camera::Move(const glm::vec3& offset)
+{
+    if (mode == CameraMode::Fly)
+        goalPos += offset;
+}
+
+void Camera::SetOrientation(const glm::quat& orientation)
+{
+    goalOrientation = glm::normalize(orientation);
+    pitch = PitchOf(goalOrientation);
+    if (goalOrientation == this->orientation)
+        return;
+    this->orientation = goalOrientation;
+    orientationDirty = true;
+    viewDirty = true;
+}
+
+void Camera::SetYawPitch(float yaw, float pitch)
+{
+    SetOrientation(OrientationFromYawPitch(yaw, pitch));
+}
+
+glm::quat Camera::OrientationFromYawPitch(float yaw, float pitch)
+{
+    if (pitch > 89.0f)
+        pitch = 89.0f;
+    if (pitch < -89.0f)
+        pitch = -89.0f;
+    glm::quat yawRotation = glm::angleAxis(glm::radians(-(yaw + 90.0f)), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::quat pitchRotation = glm::angleAxis(glm::radians(pitch), glm::vec3(1.0f, 0.0f, 0.0f));
+    return glm::normalize(yawRotation * pitchRotation);
+}
+
+void Camera::AddYawPitch(float yawOffset, float pitchOffset)
+{
+    if (pitch + pitchOffset > 89.0f)
+        pitchOffset = 89.0f - pitch;
+    if (pitch + pitchOffset < -89.0f)
+        pitchOffset = -89.0f - pitch;
+    if (yawOffset == 0.0f && pitchOffset == 0.0f)
+        return;
+    pitch += pitchOffset;
+
+    // yaw about the world up axis, pitch about the camera's own right axis
+    glm::quat yawRotation = glm::angleAxis(glm::radians(-yawOffset), worldUp);
+    glm::quat pitchRotation = glm::angleAxis(glm::radians(pitchOffset), glm::vec3(1.0f, 0.0f, 0.0f));
+    goalOrientation = glm::normalize(yawRotation * goalOrientation * pitchRotation);
+}
+
+void Camera::SetOrbitTarget(const glm::vec3& target, float distance)
+{
+    orbitTarget = target;
+    goalDistance = distance;
+}
+
+void Camera::Zoom(float factor)
+{
+    goalDistance = std::max(goalDistance * factor, nearPlane);
+}
+
+void Camera::SetFov(float degrees)
+{
+    if (degrees == fov)
+        return;
+    fov = degrees;
+    projectionDirty = true;
+}
+
+void Camera::SetAspect(float aspect)
+{
+    if (aspect == this->aspect || !(aspect > 0.0f))
+        return;
+    this->aspect = aspect;
+    projectionDirty = true;
+}
+
+void Camera::SetClipPlanes(float nearPlane, float farPlane)
+{
+    if (nearPlane == this->nearPlane && farPlane == this->farPlane)
+        return;
+    this->nearPlane = nearPlane;
+    this->farPlane = farPlane;
+    projectionDirty = true;
+}
+
+const glm::vec3& Camera::GetFront() const
+{
+    if (orientationDirty)
+        UpdateOrientation();
+    return cameraFront;
+}
+
+const glm::vec3& Camera::GetRight() const
+{
+    if (orientationDirty)
+        UpdateOrientation();
+    return cameraRight;
+}
+
+void Camera::UpdateOrientation() const
+{
+    cameraFront = orientation * glm::vec3(0.0f, 0.0f, -1.0f);
+    cameraRight = orientation * glm::vec3(1.0f, 0.0f, 0.0f);
+    orientationDirty = false;
+}
+
+float Camera::PitchOf(const glm::quat& q) const
+{
+    glm::vec3 front = q * glm::vec3(0.0f, 0.0f, -1.0f);
+    return glm::degrees(std::asin(glm::clamp(front.y, -1.0f, 1.0f)));
+}
+
+void Camera::Update(float deltaTime)
+{
+    float t = damping > 0.0f ? 1.0f - std::exp(-damping * deltaTime) : 1.0f;
+
+    // normalised lerp is plenty for the small per-frame steps and needs no trig, unlike slerp
+    glm::quat goal = glm::dot(orientation, goalOrientation) < 0.0f ? -goalOrientation : goalOrientation;
+    if (glm::dot(orientation, goal) > 0.9999999f)
+    {
+        if (orientation != goalOrientation)
+        {
+            orientation = goalOrientation;
+            orientationDirty = true;
+        }
+    }
+    else
+    {
+        orientation = glm::normalize(glm::lerp(orientation, goal, t));
+        orientationDirty = true;
+    }
+
+    if (std::abs(goalDistance - orbitDistance) < 1e-5f)
+        orbitDistance = goalDistance;
+    else
+        orbitDistance += (goalDistance - orbitDistance) * t;
+
+    glm::vec3 position;
+    if (mode == CameraMode::Orbit)
+    {
+        position = orbitTarget - GetFront() * orbitDistance;
+    }
+    else
+    {
+        glm::vec3 d = goalPos - cameraPos;
+        position = glm::dot(d, d) < 1e-10f ? goalPos : cameraPos + d * t;
+    }
+
+    if (orientationDirty || position != cameraPos)
+    {
+        cameraPos = position;
+        viewDirty = true;
+    }
+}
+
 void Camera::tick()
 {
-    // glm::vec3 cameraPos = glm::vec3(0.0f, 0.0f, 3.0f);
-    glm::vec3 cameraTarget = glm::vec3(0.0f, 0.0f, 0.0f);
-    glm::vec3 cameraDirection = glm::normalize(cameraPos - cameraTarget);
+    if (!viewDirty && !projectionDirty)
+        return;
 
-    glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f); 
-    glm::vec3 cameraRight = glm::normalize(glm::cross(up, cameraDirection));
+    if (viewDirty)
+    {
+        // inverse of the camera transform: transposed rotation, rotated negative translation
+        glm::quat inverse = glm::conjugate(orientation);
+        view = glm::mat4_cast(inverse);
+        view[3] = glm::vec4(inverse * -cameraPos, 1.0f);
+    }
+    if (projectionDirty)
+        projection = glm::perspective(glm::radians(fov), aspect, nearPlane, farPlane);
 
-    direction.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
-    direction.y = sin(glm::radians(pitch));
-    direction.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch)); 
-    // glm::vec3 cameraUp = glm::cross(cameraDirection, cameraRight);
+    viewProjection = projection * view;
+    frustum.FromMatrix(viewProjection);
+    viewDirty = false;
+    projectionDirty = false;
+    version++;
 }
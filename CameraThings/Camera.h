@@ -1,24 +1,117 @@
 ﻿#pragma once
+#include <cstdint>
 #include <glm/fwd.hpp>
 #include <glm/geometric.hpp>
+#include <glm/mat4x4.hpp>
 #include <glm/vec3.hpp>
 #include <glm/ext/matrix_clip_space.hpp>
+#include <glm/gtc/quaternion.hpp>
 
+#include "Frustum.h"
+
+enum class CameraMode
+{
+    Fly,   // moves freely, looks around its own position
+    Orbit  // circles a target point at a given distance
+};
+
+/// \brief Camera with a quaternion orientation that owns its view, projection and frustum.
+/// Input (Move, AddYawPitch, Zoom) changes a goal state that Update() eases towards, so
+/// motion is smoothed; SetPosition/SetOrientation jump straight there. tick() rebuilds the
+/// matrices once per frame only if something changed and bumps the version, so anything
+/// derived from the camera can skip work while it stands still. Building the view matrix
+/// from the quaternion needs no trigonometry.
 class Camera
 {
 public:
+    void SetMode(CameraMode mode);
+    CameraMode GetMode() const { return mode; }
 
-    glm::vec3 cameraPos   = glm::vec3(0.0f, 0.0f,  3.0f);
-    glm::vec3 cameraFront = glm::vec3(0.0f, 0.0f, -1.0f);
-    glm::vec3 cameraUp    = glm::vec3(0.0f, 1.0f,  0.0f);
+    void SetPosition(const glm::vec3& position);
+    const glm::vec3& GetPosition() const { return cameraPos; }
+    float GetFarPlane() const { return farPlane; }
+
+    /// \brief Fly mode: moves the goal position. Ignored while orbiting.
+    void Move(const glm::vec3& offset);
+
+    void SetOrientation(const glm::quat& orientation);
+    const glm::quat& GetOrientation() const { return orientation; }
+
+    /// \brief Jumps to the orientation given by Euler angles in degrees (yaw -90 looks down -z)
+    void SetYawPitch(float yaw, float pitch);
+    static glm::quat OrientationFromYawPitch(float yaw, float pitch);
+
+    /// \brief Mouse look in degrees. Flying turns the camera; orbiting circles the target.
+    /// Pitch stays within +-89 degrees of the horizon.
+    void AddYawPitch(float yawOffset, float pitchOffset);
+
+    /// \brief Point to orbit around, e.g. the centre of a dataset's bounds
+    void SetOrbitTarget(const glm::vec3& target, float distance);
+    /// \brief Orbit mode: scales the distance to the target, < 1 moves closer
+    void Zoom(float factor);
+
+    /// \brief How fast the camera catches up with its goal, per second. 0 disables smoothing.
+    void SetDamping(float rate) { damping = rate; }
 
-    glm::vec3 direction;
+    void SetFov(float degrees);
+    void SetAspect(float aspect);
+    void SetClipPlanes(float nearPlane, float farPlane);
+    float GetFov() const { return fov; }
 
-    float yaw = -90.0f;
-    float pitch = 0.f;
-    float roll = 0.f;
+    /// \brief Unit vectors of the current orientation, derived lazily without trigonometry
+    const glm::vec3& GetFront() const;
+    const glm::vec3& GetRight() const;
+    const glm::vec3& GetUp() const { return worldUp; }
+
+    /// \brief Eases the camera towards its goal state
+    void Update(float deltaTime);
+
+    /// \brief Rebuilds the matrices and frustum if the camera changed since the last tick
     void tick();
 
+    const glm::mat4& GetView() const { return view; }
+    const glm::mat4& GetProjection() const { return projection; }
+    const glm::mat4& GetViewProjection() const { return viewProjection; }
+    const Frustum& GetFrustum() const { return frustum; }
+
+    /// \brief Increases every time tick() rebuilds the matrices
+    uint64_t GetVersion() const { return version; }
+
+private:
+    CameraMode mode = CameraMode::Fly;
+    const glm::vec3 worldUp = glm::vec3(0.0f, 1.0f, 0.0f);
+
+    // current state
+    glm::vec3 cameraPos   = glm::vec3(0.0f, 0.0f,  3.0f);
+    glm::quat orientation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f); // identity looks down -z
+    float orbitDistance = 3.0f;
+
+    // state the camera eases towards
+    glm::vec3 goalPos = cameraPos;
+    glm::quat goalOrientation = orientation;
+    float goalDistance = orbitDistance;
+    glm::vec3 orbitTarget = glm::vec3(0.0f);
+    float pitch = 0.0f; // of the goal orientation, tracked so it can be clamped without trig
+    float damping = 12.0f;
+
+    mutable glm::vec3 cameraFront = glm::vec3(0.0f, 0.0f, -1.0f);
+    mutable glm::vec3 cameraRight = glm::vec3(1.0f, 0.0f,  0.0f);
+
+    float fov = 45.0f;
+    float aspect = 800.0f / 600.0f;
+    float nearPlane = 0.1f;
+    float farPlane = 100.0f;
+
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 projection = glm::mat4(1.0f);
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    Frustum frustum;
+
+    mutable bool orientationDirty = true;
+    bool viewDirty = true;
+    bool projectionDirty = true;
+    uint64_t version = 0;
 
-    
+    void UpdateOrientation() const;
+    float PitchOf(const glm::quat& q) const;
 };
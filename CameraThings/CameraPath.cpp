@@ -0,0 +1,141 @@
+﻿#include "CameraPath.h"
+
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+    const char Magic[4] = { 'C', 'A', 'M', 'P' };
+    const uint32_t FormatVersion = 2;
+
+    struct Header
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t frameCount;
+        float deltaTime;
+    };
+
+    struct CameraPathFrameV1
+    {
+        float position[3];
+        float yaw;
+        float pitch;
+        float fov;
+    };
+}
+
+CameraRecorder::~CameraRecorder()
+{
+    Close();
+}
+
+bool CameraRecorder::Open(const std::string& filename, float deltaTime)
+{
+    file.open(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        std::cout << "Unable to open file: " << filename << std::endl;
+        return false;
+    }
+
+    Header header;
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = FormatVersion;
+    header.frameCount = 0; // patched in Close()
+    header.deltaTime = deltaTime;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    frameCount = 0;
+    return true;
+}
+
+void CameraRecorder::Record(const Camera& camera)
+{
+    if (!file.is_open())
+        return;
+
+    CameraPathFrame frame;
+    frame.position[0] = camera.GetPosition().x;
+    frame.position[1] = camera.GetPosition().y;
+    frame.position[2] = camera.GetPosition().z;
+    frame.orientation[0] = camera.GetOrientation().w;
+    frame.orientation[1] = camera.GetOrientation().x;
+    frame.orientation[2] = camera.GetOrientation().y;
+    frame.orientation[3] = camera.GetOrientation().z;
+    frame.fov = camera.GetFov();
+    file.write(reinterpret_cast<const char*>(&frame), sizeof(frame));
+    frameCount++;
+}
+
+void CameraRecorder::Close()
+{
+    if (!file.is_open())
+        return;
+
+    file.seekp(offsetof(Header, frameCount));
+    file.write(reinterpret_cast<const char*>(&frameCount), sizeof(frameCount));
+    file.close();
+}
+
+bool CameraPath::Load(const std::string& filename)
+{
+    frames.clear();
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open())
+    {
+        std::cout << "Unable to open file: " << filename << std::endl;
+        return false;
+    }
+
+    Header header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version < 1 || header.version > FormatVersion)
+    {
+        std::cout << "Not a camera path file: " << filename << std::endl;
+        return false;
+    }
+
+    // a recording cut short (crash, killed process) still has its frames, only the count is 0
+    CameraPathFrame frame;
+    if (header.version == 1)
+    {
+        CameraPathFrameV1 old;
+        while (file.read(reinterpret_cast<char*>(&old), sizeof(old)))
+        {
+            glm::quat q = Camera::OrientationFromYawPitch(old.yaw, old.pitch);
+            std::memcpy(frame.position, old.position, sizeof(frame.position));
+            frame.orientation[0] = q.w;
+            frame.orientation[1] = q.x;
+            frame.orientation[2] = q.y;
+            frame.orientation[3] = q.z;
+            frame.fov = old.fov;
+            frames.push_back(frame);
+        }
+    }
+    else
+    {
+        while (file.read(reinterpret_cast<char*>(&frame), sizeof(frame)))
+            frames.push_back(frame);
+    }
+    if (header.frameCount != 0 && header.frameCount < frames.size())
+        frames.resize(header.frameCount);
+
+    deltaTime = header.deltaTime > 0.0f ? header.deltaTime : deltaTime;
+    return true;
+}
+
+void CameraPath::Apply(size_t frame, Camera& camera) const
+{
+    if (frames.empty())
+        return;
+    if (frame >= frames.size())
+        frame = frames.size() - 1;
+
+    // recorded poses are absolute, so replay flies even if the user was orbiting
+    const CameraPathFrame& f = frames[frame];
+    camera.SetMode(CameraMode::Fly);
+    camera.SetPosition(glm::vec3(f.position[0], f.position[1], f.position[2]));
+    camera.SetOrientation(glm::quat(f.orientation[0], f.orientation[1], f.orientation[2], f.orientation[3]));
+    camera.SetFov(f.fov);
+}
@@ -0,0 +1,52 @@
+﻿#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Camera.h"
+
+/// \brief Camera state for one frame, as stored in a .campath file
+struct CameraPathFrame
+{
+    float position[3];
+    float orientation[4]; // quaternion w, x, y, z
+    float fov;
+};
+
+/// \brief Writes the camera state every frame to a compact binary file:
+/// a 16 byte header ("CAMP", format version, frame count, delta time) followed by one
+/// CameraPathFrame per frame, little endian as written by x86/x64. Version 1 files, which
+/// stored yaw/pitch instead of a quaternion, can still be loaded.
+class CameraRecorder
+{
+public:
+    ~CameraRecorder();
+
+    /// \param deltaTime the frame time the path should be replayed with
+    bool Open(const std::string& filename, float deltaTime);
+    void Record(const Camera& camera);
+    void Close();
+    bool IsOpen() const { return file.is_open(); }
+
+private:
+    std::ofstream file;
+    uint32_t frameCount = 0;
+};
+
+/// \brief A recorded flight, loaded whole so replay never touches the disk mid-run
+class CameraPath
+{
+public:
+    bool Load(const std::string& filename);
+
+    size_t GetFrameCount() const { return frames.size(); }
+    float GetDeltaTime() const { return deltaTime; }
+
+    /// \brief Puts the camera where it was on the given frame
+    void Apply(size_t frame, Camera& camera) const;
+
+private:
+    std::vector<CameraPathFrame> frames;
+    float deltaTime = 1.0f / 60.0f;
+};
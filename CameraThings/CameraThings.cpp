@@ -4,27 +4,94 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <random>
 #include <vector>
+#ifdef _WIN32
+#define NOMINMAX
 #include <windows.h>
+#endif
 
+#include "Benchmarks.h"
 #include "Camera.h"
+#include "CameraPath.h"
+#include "CommandBuffer.h"
+#include "CurveBatch.h"
 #include "FileManager.h"
+#include "FrameStats.h"
+#include "GlBackend.h"
+#include "GlExtensions.h"
+#include "GlState.h"
+#include "InputQueue.h"
 #include "Kube.h"
+#include "OffscreenTarget.h"
+#include "PhysicsWorld.h"
+#include "PngWriter.h"
+#include "Profiler.h"
+#include "ProgramCache.h"
 #include "Shader.h"
+#include "ShaderLibrary.h"
+#include "SoftwareBackend.h"
 
 
 #pragma region Public Variables
 
 Camera MainCamera;
 FileManager fileManager;
-Shader shader;
+ProgramCache programCache; // linked program binaries, reused across launches
+ShaderLibrary shaderLibrary(&programCache); // Scene.vert/Scene.frag permutations, built on first use
+Shader* shader = nullptr;
+Shader* curveShader = nullptr;
+Shader* lineShader = nullptr;      // wide lines, WideLine.vert
+Shader* curveLineShader = nullptr; // wide lines for curve batches
+Shader* splatShader = nullptr;
+Shader* splatResolveShader = nullptr;
 Kube k(1.0f);
-
-bool firstMouse = true; // Used in mouse_callback
-
-
-float lastX = 400, lastY = 300; //Used in mouse_callback
+GlState glState; // skips GL calls that would not change anything in the render loop
+PhysicsWorld physicsWorld;
+
+std::unique_ptr<RenderBackend> backend; // GlBackend, or SoftwareBackend with --software
+MeshHandle curveMesh = 0;
+MeshHandle bodyMesh = 0; // dynamic bodies, drawn as points
+// the frame's draws, sorted before they reach the backend. Recorded on this thread only:
+// a handful of draws per frame is not worth handing to the workers.
+CommandBuffer commands;
+CurveBatch curveBatch;  // --curves: copies of the dataset overlaid, all in one draw call
+LineJoin lineJoin = LineJoin::Miter; // --line-join miter|round
+PointMode pointMode = PointMode::Square;
+bool datasetPoints = false; // --points square|splat|blend: the dataset is an unordered cloud, not a curve
+std::vector<glm::vec3> bodyPositions;
+std::vector<float> bodyFloats;
+
+InputQueue inputQueue; // filled by the GLFW callbacks, drained once per frame in processInput
+
+CameraRecorder cameraRecorder; // --record: writes MainCamera every frame
+CameraPath cameraPath;         // --replay: drives MainCamera instead of the user
+bool replaying = false;
+size_t frameIndex = 0;
+
+// --headless: invisible window with an EGL or OSMesa context, drawing into an FBO. GLFW 3.3
+// still needs a display server for that (Xvfb will do); --software needs none.
+bool headless = false;
+int headlessContextApi = GLFW_EGL_CONTEXT_API;
+OffscreenTarget offscreen;
+bool software = false; // --software: no window and no GL, frames come from the CPU rasterizer
+std::string pngPrefix; // --dump-png: every frame is written to <prefix>_00000.png, ...
+size_t frameLimit = 0; // --frames: 0 runs until the window closes
+std::string profilePath; // --profile: Chrome trace of CPU and GPU scopes, written on exit
+FrameStats frameStats;   // frame time percentiles, printed on exit; --stats-csv, --stats-interval
+bool benchmark = false;  // --benchmark: uncapped, GPU-synchronised frames and a JSON report
+std::string benchmarkPath;
+int swapInterval = -1;   // --swap-interval: -1 keeps the driver's default
+std::vector<uint8_t> framePixels;
 
 float deltaTime = 0.0f;	// Time between current frame and last frame
 float lastFrame = 0.0f; // Time of last frame
@@ -33,14 +100,23 @@ float lastFrame = 0.0f; // Time of last frame
 
 #pragma region Function Declarations
 
-void setup(GLFWwindow*& window, unsigned& shaderProgram, unsigned& VBO, unsigned& VAO, unsigned& EBO,
-               int& vertexColorLocation, int& value1, std::vector<float> floats);
-void render(GLFWwindow* window, unsigned shaderProgram, unsigned VAO, int vertexColorLocation, std::vector<Vertex> points);
+void setup(GLFWwindow*& window, int& value1);
+void render(GLFWwindow* window);
 
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow *window);
 
+void spawnBodies(int count);
+void setupBodies();
+void drawBodies();
+float pointSizeFor(float pixels, float worldSize);
+void buildCurveBatch(const std::vector<Vertex>& points, int count, const glm::vec3& center);
+float viewDepth(const glm::vec3& position);
+void dumpFrame();
+
 std::string readFile(const std::string& filename);
 std::vector<float> convertPointsToFloats(const std::vector<Vertex>& points, float scale);
 std::vector<Vertex> readPointsFromFile(const std::string& filename);
@@ -52,48 +128,260 @@ std::vector<Vertex> readPointsFromFile(const std::string& filename);
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
 
-std::string vertexShaderSourceString = fileManager.readFile("NewVertShader.vert");
-std::string fragmentShaderSourceString = fileManager.readFile("FragmentShader.frag");
-
-const char *vertexShaderSource = vertexShaderSourceString.c_str();
-const char *fragmentShaderSource = fragmentShaderSourceString.c_str();
+// program ids in command buffer sort keys
+const uint32_t SceneProgram = 0;
+const uint32_t CurveProgram = 1;
+const uint32_t SplatProgram = 2;
 
 #pragma endregion
 
 
-int main()
+int main(int argc, char* argv[])
 {
+    int bodyCount = 0;
+    int curveCount = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--curves") == 0 && i + 1 < argc)
+        {
+            curveCount = std::atoi(argv[++i]);
+            continue;
+        }
+        if (std::strcmp(argv[i], "--points") == 0 && i + 1 < argc)
+        {
+            datasetPoints = true;
+            i++;
+            if (std::strcmp(argv[i], "splat") == 0)
+                pointMode = PointMode::Splat;
+            else if (std::strcmp(argv[i], "blend") == 0)
+                pointMode = PointMode::BlendedSplat;
+            continue;
+        }
+        if (std::strcmp(argv[i], "--profile") == 0 && i + 1 < argc)
+        {
+            profilePath = argv[++i];
+            continue;
+        }
+        if (std::strcmp(argv[i], "--stats-csv") == 0 && i + 1 < argc)
+        {
+            frameStats.OpenCsv(argv[++i]);
+            continue;
+        }
+        if (std::strcmp(argv[i], "--stats-interval") == 0 && i + 1 < argc)
+        {
+            frameStats.SetReportInterval(std::atof(argv[++i]));
+            continue;
+        }
+        if (std::strcmp(argv[i], "--benchmark") == 0 && i + 1 < argc)
+        {
+            benchmark = true;
+            benchmarkPath = argv[++i];
+            continue;
+        }
+        if (std::strcmp(argv[i], "--swap-interval") == 0 && i + 1 < argc)
+        {
+            swapInterval = std::atoi(argv[++i]);
+            continue;
+        }
+        if (std::strcmp(argv[i], "--line-join") == 0 && i + 1 < argc)
+        {
+            lineJoin = std::strcmp(argv[++i], "round") == 0 ? LineJoin::Round : LineJoin::Miter;
+            continue;
+        }
+        if (std::strcmp(argv[i], "--bodies") == 0 && i + 1 < argc)
+        {
+            bodyCount = std::atoi(argv[++i]);
+            continue;
+        }
+        if (std::strcmp(argv[i], "--no-shader-cache") == 0)
+        {
+            programCache.SetEnabled(false);
+            continue;
+        }
+        if (std::strcmp(argv[i], "--headless") == 0)
+        {
+            // optionally followed by "egl" (default) or "osmesa"
+            headless = true;
+            if (i + 1 < argc && std::strcmp(argv[i + 1], "egl") == 0)
+                i++;
+            else if (i + 1 < argc && std::strcmp(argv[i + 1], "osmesa") == 0)
+            {
+                headlessContextApi = GLFW_OSMESA_CONTEXT_API;
+                i++;
+            }
+            continue;
+        }
+        if (std::strcmp(argv[i], "--software") == 0)
+        {
+            software = true;
+            continue;
+        }
+        if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+        {
+            frameLimit = std::strtoul(argv[++i], nullptr, 10);
+            continue;
+        }
+        if (std::strcmp(argv[i], "--dump-png") == 0 && i + 1 < argc)
+        {
+            pngPrefix = argv[++i];
+            continue;
+        }
+        if (std::strcmp(argv[i], "--hot-reload") == 0)
+        {
+            shaderLibrary.EnableHotReload();
+            continue;
+        }
+        if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+        {
+            cameraRecorder.Open(argv[++i], 1.0f / 60.0f);
+            continue;
+        }
+        if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+        {
+            replaying = cameraPath.Load(argv[++i]);
+            continue;
+        }
+        if (std::strcmp(argv[i], "--broadphase") == 0 && i + 1 < argc)
+        {
+            BroadPhaseType type;
+            if (BroadPhase::ParseType(argv[++i], type))
+                physicsWorld.SetBroadPhase(type);
+            else
+                std::cout << "Unknown broad phase: " << argv[i] << " (use grid or sap)" << std::endl;
+            continue;
+        }
+        if (std::strcmp(argv[i], "--bench-bvh") == 0)
+        {
+            Benchmarks::RunBvh();
+            return 0;
+        }
+        if (std::strcmp(argv[i], "--bench-broadphase") == 0)
+        {
+            // optionally followed by "grid" or "sap" to run only one implementation
+            std::vector<BroadPhaseType> types = { BroadPhaseType::Grid, BroadPhaseType::SweepAndPrune };
+            BroadPhaseType only;
+            if (i + 1 < argc && BroadPhase::ParseType(argv[i + 1], only))
+                types = { only };
+            Benchmarks::RunBroadPhase(types);
+            return 0;
+        }
+    }
+
+    // a benchmark runs the replay, or a fixed number of frames, as fast as it can
+    if (benchmark)
+    {
+        if (frameLimit == 0 && !replaying)
+            frameLimit = 600;
+        if (swapInterval < 0)
+            swapInterval = 0;
+        frameStats.SetWaitForGpu(true);
+    }
+    // nobody can close a headless window, so it stops after one frame or at the end of the replay
+    if ((headless || software) && frameLimit == 0 && !replaying)
+        frameLimit = 1;
+    // without a window the PNGs are the only output, except for a benchmark
+    if (software && pngPrefix.empty() && !benchmark)
+        pngPrefix = "frame";
+
     std::vector<Vertex> points = fileManager.readPointsFromFile("spiralpunkter2.txt");
     std::vector<float> floats = fileManager.convertPointsToFloats(points, 1/9.9f);
-    
-    GLFWwindow* window;
-    unsigned shaderProgram, VBO, VAO, EBO;
-    int vertexColorLocation, value1;
-    
-    setup(window, shaderProgram, VBO, VAO, EBO, vertexColorLocation, value1, floats);
 
+    // orbit mode circles the middle of the dataset
+    Aabb dataBounds;
+    for (const Vertex& p : points)
+        dataBounds.Grow(glm::vec3(p.x, p.y, p.z) / 9.9f);
+    if (dataBounds.IsValid())
+        MainCamera.SetOrbitTarget(dataBounds.Center(), 3.0f);
     
-    render(window, shaderProgram, VAO, vertexColorLocation, points);
+    GLFWwindow* window = nullptr;
+    int value1 = 0;
+    if (software)
+    {
+        backend.reset(new SoftwareBackend(SCR_WIDTH, SCR_HEIGHT));
+    }
+    else
+    {
+        setup(window, value1);
+        if (value1 == -1)
+            return -1;
+        GlBackend::Programs programs;
+        programs.scene = shader;
+        programs.curves = curveShader;
+        programs.lines = lineShader;
+        programs.curveLines = curveLineShader;
+        programs.splats = splatShader;
+        programs.splatResolve = splatResolveShader;
+        backend.reset(new GlBackend(programs, glState));
+        Profiler::EnableGpu();
+    }
+    std::cout << "Render backend: " << backend->GetName() << std::endl;
+    backend->SetLineJoin(lineJoin);
+    backend->SetPointMode(pointMode);
+
+    curveMesh = backend->CreateMesh(floats.data(), floats.size() / RenderBackend::FloatsPerVertex, nullptr, 0, false);
+    buildCurveBatch(points, curveCount, dataBounds.IsValid() ? dataBounds.Center() : glm::vec3(0.0f));
+    spawnBodies(bodyCount);
+    setupBodies();
+
+    if (!profilePath.empty())
+        Profiler::Start();
+    frameStats.Start(!software);
+    render(window);
+    cameraRecorder.Close();
+    frameStats.Finish();
+    frameStats.PrintSummary(std::cout);
+    if (benchmark)
+    {
+        std::map<std::string, std::string> run;
+        run["backend"] = backend->GetName();
+        run["renderer"] = software ? "CPU rasterizer" : reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+        run["mode"] = software ? "software" : headless ? "headless" : "window";
+        run["camera"] = replaying ? "replay" : "fixed";
+        run["swap_interval"] = std::to_string(swapInterval);
+        run["size"] = std::to_string(SCR_WIDTH) + "x" + std::to_string(SCR_HEIGHT);
+        if (!frameStats.WriteJson(benchmarkPath, run))
+            value1 = -1;
+    }
+    if (!profilePath.empty())
+    {
+        Profiler::Stop();
+        Profiler::WriteChromeTrace(profilePath);
+    }
 
     // optional: de-allocate all resources once they've outlived their purpose:
     // ------------------------------------------------------------------------
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteBuffers(1, &EBO);
-    glDeleteProgram(shaderProgram);
+    backend.reset();
+    if (software)
+        return value1;
+    glDeleteProgram(shader->GetProgram()); // a hot reload may have replaced the program from setup
+    glDeleteProgram(curveShader->GetProgram());
+    glDeleteProgram(lineShader->GetProgram());
+    glDeleteProgram(curveLineShader->GetProgram());
+    glDeleteProgram(splatShader->GetProgram());
+    glDeleteProgram(splatResolveShader->GetProgram());
+    if (headless)
+        offscreen.Destroy();
 
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
     glfwTerminate();
-    return 0;
+    return value1;
 }
 
-void setup(GLFWwindow*& window, unsigned& shaderProgram, unsigned& VBO, unsigned& VAO, unsigned& EBO,
-               int& vertexColorLocation, int& value1, std::vector<float> floats)
+void setup(GLFWwindow*& window, int& value1)
 {
     // glfw: initialize and configure
     // ------------------------------
-    glfwInit();
+    if (!glfwInit())
+    {
+        // GLFW 3.3 has no null platform: even an invisible window needs a display
+        std::cout << "ERROR::GLFW::INIT_FAILED" << std::endl;
+        if (headless)
+            std::cout << "--headless still needs a display server (e.g. a virtual one such as Xvfb); "
+                      << "use --software on machines without one" << std::endl;
+        value1 = -1;
+        return;
+    }
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -103,7 +391,20 @@ void setup(GLFWwindow*& window, unsigned& shaderProgram, unsigned& VBO, unsigned
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
 
+    if (headless)
+    {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, headlessContextApi);
+    }
+
     window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Oppgave1", NULL, NULL);
+    if (window == NULL && headless && headlessContextApi == GLFW_EGL_CONTEXT_API)
+    {
+        // no EGL (or no usable EGL device): Mesa's OSMesa renders purely in software
+        std::cout << "EGL context failed, trying OSMesa" << std::endl;
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+        window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Oppgave1", NULL, NULL);
+    }
     if (window == NULL)
     {
         std::cout << "Failed to create GLFW window" << std::endl;
@@ -113,6 +414,8 @@ void setup(GLFWwindow*& window, unsigned& shaderProgram, unsigned& VBO, unsigned
     }
     glfwMakeContextCurrent(window);
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    if (swapInterval >= 0)
+        glfwSwapInterval(swapInterval); // 0 lets frames run past the display's refresh rate
 
     // glad: load all OpenGL function pointers
     // ---------------------------------------
@@ -123,159 +426,317 @@ void setup(GLFWwindow*& window, unsigned& shaderProgram, unsigned& VBO, unsigned
         return;
     }
     
-    shader.CreateVertexShader(vertexShaderSource);
-    shader.CreateFragmentShader(fragmentShaderSource);
-    shader.LinkProgram();
-    shaderProgram = shader.GetProgram();
+    GlExtensions::Load((GLADloadproc)glfwGetProcAddress);
+
+    // headless frames go to an FBO; it stays bound for the rest of the run
+    if (headless)
+    {
+        if (!offscreen.Create(SCR_WIDTH, SCR_HEIGHT))
+        {
+            value1 = -1;
+            return;
+        }
+        offscreen.Bind();
+        std::cout << "Headless: " << glGetString(GL_RENDERER) << std::endl;
+    }
+
+    // first launch (or after a driver/shader change) compiles, later ones load the cached binary.
+    // Every program is submitted before any is waited on, and a plain loading frame is shown
+    // until the driver has finished them.
+    auto shaderStart = std::chrono::steady_clock::now();
+    shader = shaderLibrary.Request("Scene.vert", "Scene.frag", ShaderFeatureVertexColor);
+    curveShader = shaderLibrary.Request("Scene.vert", "Scene.frag", ShaderFeatureCurveBatch);
+    lineShader = shaderLibrary.Request("WideLine.vert", "WideLine.frag", ShaderFeatureVertexColor);
+    curveLineShader = shaderLibrary.Request("WideLine.vert", "WideLine.frag", ShaderFeatureCurveBatch);
+    splatShader = shaderLibrary.Request("Splat.vert", "Splat.frag", ShaderFeatureNone);
+    splatResolveShader = shaderLibrary.Request("SplatResolve.vert", "SplatResolve.frag", ShaderFeatureNone);
+    while (!shaderLibrary.Poll())
+    {
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+    for (Shader* program : { shader, curveShader, lineShader, curveLineShader, splatShader, splatResolveShader })
+    {
+        if (program == nullptr || !program->IsLinked())
+        {
+            value1 = -1;
+            return;
+        }
+    }
+    bool fromCache = shaderLibrary.GetCacheHits() > 0;
+    double shaderMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - shaderStart).count();
+    std::cout << "Shader setup: " << shaderMs << " ms ("
+              << (fromCache ? "warm, program cache" : programCache.IsEnabled() ? "cold, compiled and cached" : "compiled, no program cache")
+              << ")" << std::endl;
 
-    
-    // set up vertex data (and buffer(s)) and configure vertex attributes
-    // ------------------------------------------------------------------
-    float vertices[] = {
-        0.5f,  0.5f, 0.0f,  // top right
-        0.5f, -0.5f, 0.0f,  // bottom right
-        -0.5f, -0.5f, 0.0f,  // bottom left
-        -0.5f,  0.5f, 0.0f   // top left 
-    };
-    unsigned int indices[] = {  // note that we start from 0!
-        0, 1, 3,  // first Triangle
-        1, 2, 3   // second Triangle
-    };
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-    // bind the Vertex Array Object first, then bind and set vertex buffer(s), and then configure vertex attributes(s).
-    glBindVertexArray(VAO);
-
-    vertexColorLocation = glGetUniformLocation(shaderProgram,"Color");
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, floats.size()*sizeof(float), floats.data() , GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3*sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-    // You can unbind the VAO afterwards so other VAO calls won't accidentally modify this VAO, but this rarely happens. Modifying other
-    // VAOs requires a call to glBindVertexArray anyways so we generally don't unbind VAOs (nor VBOs) when it's not directly necessary.
-    glBindVertexArray(0);
-    
     glEnable(GL_DEPTH_TEST);
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
     glfwSetCursorPosCallback(window, mouse_callback);  
+    glfwSetKeyCallback(window, key_callback);
+    glfwSetScrollCallback(window, scroll_callback);
 
     // uncomment this call to draw in wireframe polygons.
     //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
     return;
 }
 
-void render(GLFWwindow* window, unsigned shaderProgram, unsigned VAO, int vertexColorLocation, std::vector<Vertex> points)
+void render(GLFWwindow* window)
 {
-    glm::mat4 trans = glm::mat4(1.0f);
+    glState.Invalidate(); // setup bound things without it
 
-    glm::mat4 projection;
     // render loop
     // -----------
-    while (!glfwWindowShouldClose(window))
+    bool running = true;
+    while (running && (window == nullptr || !glfwWindowShouldClose(window)))
     {
-        float currentFrame = glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;  
+        // a replay draws exactly the frames it recorded
+        if (replaying && frameIndex >= cameraPath.GetFrameCount())
+            break;
+
+        PROFILE_SCOPE("Frame");
+        frameStats.BeginFrame();
+        glState.BeginFrame();
+
+        // edited shader files are rebuilt while we keep drawing with the old programs
+        if (window && shaderLibrary.Update() > 0)
+            glState.Invalidate();
+
+        if (window)
+        {
+            float currentFrame = glfwGetTime();
+            deltaTime = currentFrame - lastFrame;
+            lastFrame = currentFrame;
+        }
+        else
+        {
+            deltaTime = 1.0f / 60.0f; // no clock to follow, step like a 60 Hz display
+        }
+
+        // a replay always steps by the recorded frame time, so a flight renders the same frames on every run
+        if (replaying)
+            deltaTime = cameraPath.GetDeltaTime();
         
         // input
         // -----
-        processInput(window);
+        if (window)
+            processInput(window);
 
-        glm::mat4 model = glm::mat4(1.0f);
-        //model = glm::rotate(model, (float)glfwGetTime() * glm::radians(50.0f), glm::vec3(0.5f, 1.0f, 0.0f));
+        if (replaying)
+            cameraPath.Apply(frameIndex, MainCamera);
+        frameIndex++;
+        if (frameLimit > 0 && frameIndex >= frameLimit)
+            running = false;
 
-        int modelLoc = glGetUniformLocation(shaderProgram, "model");
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-
-        projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
-        int projectionLoc = glGetUniformLocation(shaderProgram, "projection");
-        glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
-        
+        // fixed timestep simulation, catches up with however much time the frame took
+        physicsWorld.Advance(deltaTime);
 
+        // eases towards the input goal, then rebuilds view/projection only if the camera moved, turned or the window was resized
+        MainCamera.Update(deltaTime);
         MainCamera.tick();
+        cameraRecorder.Record(MainCamera); // the pose this frame is drawn with
 
-        const float radius = 10.0f;
-        float camX = sin(glfwGetTime()) * radius;
-        float camZ = cos(glfwGetTime()) * radius;
-        glm::mat4 view;
-        view = glm::lookAt(MainCamera.cameraPos, MainCamera.cameraPos + MainCamera.cameraFront, MainCamera.cameraUp);
-        
-        // glm::mat4 view = glm::mat4(1.0f);
-        // // note that we're translating the scene in the reverse direction of where we want to move
-        // view = glm::translate(view, glm::vec3(0.0f, 0.0f, -3.0f));
-        
-        int viewLoc = glGetUniformLocation(shaderProgram, "view");
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-
-        // Update the transformation matrix
-        //trans *= glm::translate(glm::mat4(1.0f), glm::vec3(0.01f, -0.01f, 0.0f));
-        
-        //trans *= glm::rotate(glm::mat4(1.0f), glm::radians(1.0f)/100.f, glm::vec3(0.0f, 0.0f, 1.0f));
-        
-        // Pass the transformation matrix to the vertex shader
-        unsigned int transformLoc = glGetUniformLocation(shaderProgram, "transform");
-        glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(trans));
-        
         // render
         // ------
-        
-        
-        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        
-        glUniform4f(vertexColorLocation, 0.0f, 1.0f, 0.0f, 1.0f);
-        glUseProgram(shaderProgram);
-        glBindVertexArray(VAO);
-
-        glLineWidth(12);
-        glDrawArrays(GL_LINE_STRIP, 0, points.size());
-        
-        
-        // glDrawElements(GL_TRIANGLES, 3, GL_UNSIGNED_INT, 0);
-        //
-        // glUniform4f(vertexColorLocation, 1.0f, 1.0f, 0.0f, 1.0f);
-        // glDrawElements(GL_TRIANGLES, 3, GL_UNSIGNED_INT, (void*)(3 * sizeof(unsigned int)));
+        commands.Reset();
+        glm::mat4 model = glm::mat4(1.0f);
+        //model = glm::rotate(model, (float)glfwGetTime() * glm::radians(50.0f), glm::vec3(0.5f, 1.0f, 0.0f));
+        if (datasetPoints)
+            commands.GetRecorder().Draw(CommandBuffer::MakeKey(RenderPass::Opaque, SplatProgram, curveMesh, viewDepth(glm::vec3(model[3]))),
+                                        curveMesh, PrimitiveType::Points, model, pointSizeFor(4.0f, 0.03f));
+        else
+            commands.GetRecorder().Draw(CommandBuffer::MakeKey(RenderPass::Opaque, SceneProgram, curveMesh, viewDepth(glm::vec3(model[3]))),
+                                        curveMesh, PrimitiveType::LineStrip, model, 12.0f);
+        if (curveBatch.GetCurveCount() > 0)
+            commands.GetRecorder().DrawCurves(CommandBuffer::MakeKey(RenderPass::Opaque, CurveProgram, 0, viewDepth(glm::vec3(model[3]))),
+                                              curveBatch, model, 2.0f);
+        drawBodies();
+
+        {
+            PROFILE_SCOPE("Draw");
+            PROFILE_GPU_SCOPE("Draw");
+            backend->BeginFrame(MainCamera, glm::vec4(0.2f, 0.3f, 0.3f, 1.0f));
+            commands.Submit(*backend);
+            backend->EndFrame();
+        }
+
+        if (!pngPrefix.empty())
+            dumpFrame();
  
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        if (window)
+        {
+            PROFILE_SCOPE("Swap");
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
+        frameStats.EndFrame();
+        Profiler::EndFrame();
     }
+
+    glState.BeginFrame();
+    if (glState.GetFrameCount() > 0)
+    {
+        const GlState::Counters& total = glState.GetTotal();
+        std::cout << "GL state calls per frame: " << double(total.issued) / glState.GetFrameCount() << " issued, "
+                  << double(total.skipped) / glState.GetFrameCount() << " skipped" << std::endl;
+    }
+}
+
+// reads back what was just drawn and writes it as the next numbered PNG
+// ----------------------------------------------------------------------
+void dumpFrame()
+{
+    PROFILE_SCOPE("Dump PNG");
+    int width = 0, height = 0;
+    backend->ReadPixels(width, height, framePixels);
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "_%05u.png", static_cast<unsigned>(frameIndex - 1));
+    PngWriter::Write(pngPrefix + name, width, height, framePixels.data());
+}
+
+// scatter bodies through a box around the curve; they bounce off its walls, each other and the Kube
+// ---------------------------------------------------------------------------------------------------
+void spawnBodies(int count)
+{
+    if (count <= 0)
+        return;
+
+    Aabb bounds;
+    bounds.min = glm::vec3(-3.0f);
+    bounds.max = glm::vec3(3.0f);
+    physicsWorld.SetWorldBounds(bounds);
+    physicsWorld.SetStaticGeometry({ k.GetBounds() });
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> position(-3.0f, 3.0f);
+    std::uniform_real_distribution<float> velocity(-0.5f, 0.5f);
+    for (int i = 0; i < count; i++)
+    {
+        glm::vec3 p(position(rng), position(rng), position(rng));
+        glm::vec3 v(velocity(rng), velocity(rng), velocity(rng));
+        physicsWorld.AddBody(p, v, 0.02f);
+    }
+}
+
+void setupBodies()
+{
+    if (physicsWorld.GetBodyCount() == 0)
+        return;
+
+    bodyMesh = backend->CreateMesh(nullptr, physicsWorld.GetBodyCount(), nullptr, 0, true);
+}
+
+// records the bodies where they are between the last two physics steps, so motion stays smooth at any frame rate
+// ------------------------------------------------------------------------------------------------------------
+void drawBodies()
+{
+    if (physicsWorld.GetBodyCount() == 0)
+        return;
+    PROFILE_SCOPE("Bodies");
+
+    physicsWorld.GetInterpolatedPositions(bodyPositions);
+    bodyFloats.resize(bodyPositions.size() * 6);
+    for (size_t i = 0; i < bodyPositions.size(); i++)
+    {
+        float* v = &bodyFloats[i * 6];
+        v[0] = bodyPositions[i].x;
+        v[1] = bodyPositions[i].y;
+        v[2] = bodyPositions[i].z;
+        v[3] = 1.0f;
+        v[4] = 0.8f;
+        v[5] = 0.2f;
+    }
+
+    backend->UpdateMesh(bodyMesh, bodyFloats.data(), bodyPositions.size());
+    commands.GetRecorder().Draw(CommandBuffer::MakeKey(RenderPass::Opaque, SplatProgram, bodyMesh, viewDepth(glm::vec3(0.0f))),
+                                bodyMesh, PrimitiveType::Points, glm::mat4(1.0f), pointSizeFor(4.0f, 0.04f));
 }
 
-// process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
-// ---------------------------------------------------------------------------------------------------------
+// copies of the dataset turned around its centre, each in its own colour, to stand in for a session of many curves
+// ----------------------------------------------------------------------------------------------------------------
+void buildCurveBatch(const std::vector<Vertex>& points, int count, const glm::vec3& center)
+{
+    std::vector<glm::vec3> positions;
+    for (const Vertex& p : points)
+        positions.push_back(glm::vec3(p.x, p.y, p.z) / 9.9f);
+
+    for (int i = 0; i < count; i++)
+    {
+        float angle = glm::two_pi<float>() * i / count;
+        glm::mat4 transform = glm::translate(glm::mat4(1.0f), center);
+        transform = glm::rotate(transform, angle, glm::vec3(0.0f, 1.0f, 0.0f));
+        transform = glm::translate(transform, -center);
+        glm::vec4 color(0.5f + 0.5f * std::cos(angle), 0.5f + 0.5f * std::cos(angle + 2.1f), 0.5f + 0.5f * std::cos(angle + 4.2f), 1.0f);
+        curveBatch.Add(positions, color, transform);
+    }
+}
+
+// point size for the current point mode: pixels for squares, world units across for splats
+// -----------------------------------------------------------------------------------------
+float pointSizeFor(float pixels, float worldSize)
+{
+    return pointMode == PointMode::Square ? pixels : worldSize;
+}
+
+// distance from the camera as a 0..1 fraction of the far plane, for sort keys
+// ---------------------------------------------------------------------------
+float viewDepth(const glm::vec3& position)
+{
+    return glm::length(position - MainCamera.GetPosition()) / MainCamera.GetFarPlane();
+}
+
+// process all input: merge the events queued since last frame and update the camera once
+// ---------------------------------------------------------------------------------------
 void processInput(GLFWwindow *window)
 {
-    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+    InputFrame input = inputQueue.Consume();
+
+    if (inputQueue.IsKeyDown(GLFW_KEY_ESCAPE))
         glfwSetWindowShouldClose(window, true);
 
-    float cameraSpeed = 2.5f * deltaTime;
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-        MainCamera.cameraPos += cameraSpeed * MainCamera.cameraFront;
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-        MainCamera.cameraPos -= cameraSpeed * MainCamera.cameraFront;
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-        MainCamera.cameraPos -= glm::normalize(glm::cross(MainCamera.cameraFront, MainCamera.cameraUp)) * cameraSpeed;
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-        MainCamera.cameraPos += glm::normalize(glm::cross(MainCamera.cameraFront, MainCamera.cameraUp)) * cameraSpeed;
-    if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS)
-        MainCamera.cameraPos += cameraSpeed * MainCamera.cameraUp; // Move camera up
-    if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
-        MainCamera.cameraPos -= cameraSpeed * MainCamera.cameraUp; // Move camera down
+    // C switches between flying and orbiting the dataset
+    if (inputQueue.WasKeyPressed(GLFW_KEY_C))
+        MainCamera.SetMode(MainCamera.GetMode() == CameraMode::Fly ? CameraMode::Orbit : CameraMode::Fly);
+
+    if (input.mouseMoved)
+    {
+        float sensitivity = 0.1f;
+        MainCamera.AddYawPitch(input.mouseDeltaX * sensitivity, input.mouseDeltaY * sensitivity);
+    }
 
+    if (MainCamera.GetMode() == CameraMode::Orbit)
+    {
+        // W/S and the scroll wheel move towards and away from the target
+        float zoom = input.scroll;
+        if (inputQueue.IsKeyDown(GLFW_KEY_W))
+            zoom += 2.0f * deltaTime;
+        if (inputQueue.IsKeyDown(GLFW_KEY_S))
+            zoom -= 2.0f * deltaTime;
+        if (zoom != 0.0f)
+            MainCamera.Zoom(std::pow(0.9f, zoom));
+        return;
+    }
+
+    glm::vec3 move(0.0f);
+    if (inputQueue.IsKeyDown(GLFW_KEY_W))
+        move += MainCamera.GetFront();
+    if (inputQueue.IsKeyDown(GLFW_KEY_S))
+        move -= MainCamera.GetFront();
+    if (inputQueue.IsKeyDown(GLFW_KEY_A))
+        move -= MainCamera.GetRight();
+    if (inputQueue.IsKeyDown(GLFW_KEY_D))
+        move += MainCamera.GetRight();
+    if (inputQueue.IsKeyDown(GLFW_KEY_E))
+        move += MainCamera.GetUp(); // Move camera up
+    if (inputQueue.IsKeyDown(GLFW_KEY_Q))
+        move -= MainCamera.GetUp(); // Move camera down
+
+    float cameraSpeed = 2.5f * deltaTime;
+    MainCamera.Move(cameraSpeed * move);
 }
 
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
@@ -285,36 +746,24 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
     // make sure the viewport matches the new window dimensions; note that width and 
     // height will be significantly larger than specified on retina displays.
     glViewport(0, 0, width, height);
+    if (height > 0)
+        MainCamera.SetAspect((float)width / (float)height);
 }
+// glfw: cursor and key callbacks only queue the raw event, processInput acts on them once per frame
+// ----------------------------------------------------------------------------------------------------
 void mouse_callback(GLFWwindow* window, double xpos, double ypos)
- {
-     if (firstMouse)
-     {
-         lastX = xpos;
-         lastY = ypos;
-         firstMouse = false;
-     }
-   
-     float xoffset = xpos - lastX;
-     float yoffset = lastY - ypos; 
-     lastX = xpos;
-     lastY = ypos;
- 
-     float sensitivity = 0.1f;
-     xoffset *= sensitivity;
-     yoffset *= sensitivity;
- 
-     MainCamera.yaw   += xoffset;
-     MainCamera.pitch += yoffset;
- 
-     if(MainCamera.pitch > 89.0f)
-         MainCamera.pitch = 89.0f;
-     if(MainCamera.pitch < -89.0f)
-         MainCamera.pitch = -89.0f;
- 
-     glm::vec3 direction;
-     direction.x = cos(glm::radians(MainCamera.yaw)) * cos(glm::radians(MainCamera.pitch));
-     direction.y = sin(glm::radians(MainCamera.pitch));
-     direction.z = sin(glm::radians(MainCamera.yaw)) * cos(glm::radians(MainCamera.pitch));
-     MainCamera.cameraFront = glm::normalize(direction);
- }  
\ No newline at end of file
+{
+    inputQueue.PushCursor(xpos, ypos);
+}
+
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    if (action == GLFW_REPEAT)
+        return;
+    inputQueue.PushKey(key, action == GLFW_PRESS);
+}
+
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
+{
+    inputQueue.PushScroll(xoffset, yoffset);
+}  
\ No newline at end of file
@@ -0,0 +1,41 @@
+﻿#include "CameraUniformBuffer.h"
+
+#include <glad/glad.h>
+
+#include "Camera.h"
+
+static_assert(sizeof(CameraUniformBuffer::Block) == 208, "Block must match the std140 layout of CameraBlock");
+
+void CameraUniformBuffer::Create()
+{
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(Block), NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, BindingPoint, buffer);
+    uploadedVersion = 0;
+}
+
+void CameraUniformBuffer::Destroy()
+{
+    glDeleteBuffers(1, &buffer);
+    buffer = 0;
+}
+
+bool CameraUniformBuffer::Update(const Camera& camera)
+{
+    if (buffer == 0 || camera.GetVersion() == uploadedVersion)
+        return false;
+
+    Block block;
+    block.view = camera.GetView();
+    block.projection = camera.GetProjection();
+    block.viewProjection = camera.GetViewProjection();
+    block.position = glm::vec4(camera.GetPosition(), 1.0f);
+
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Block), &block);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    uploadedVersion = camera.GetVersion();
+    return true;
+}
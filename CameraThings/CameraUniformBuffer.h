@@ -0,0 +1,37 @@
+﻿#pragma once
+#include <cstdint>
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
+
+class Camera;
+
+/// \brief Per-frame camera data shared by every program through one std140 uniform buffer.
+/// Shaders declare the matching "CameraBlock" (SceneCommon.glsl); Shader binds it to
+/// BindingPoint after linking, so switching programs needs no camera uploads at all.
+class CameraUniformBuffer
+{
+public:
+    static const unsigned BindingPoint = 0;
+    static constexpr const char* BlockName = "CameraBlock";
+
+    /// \brief Mirrors the GLSL block; mat4 and vec4 members need no std140 padding
+    struct Block
+    {
+        glm::mat4 view;
+        glm::mat4 projection;
+        glm::mat4 viewProjection;
+        glm::vec4 position; // w unused
+    };
+
+    /// \brief Creates the buffer and binds it to BindingPoint; needs a current context
+    void Create();
+    void Destroy();
+
+    /// \brief Uploads the camera if its version changed since the last upload
+    /// \return true if anything was uploaded
+    bool Update(const Camera& camera);
+
+private:
+    unsigned buffer = 0;
+    uint64_t uploadedVersion = 0;
+};
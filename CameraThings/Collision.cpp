@@ -0,0 +1,102 @@
+﻿#include "Collision.h"
+
+#include <algorithm>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+void Aabb::Grow(const glm::vec3& point)
+{
+    min = glm::min(min, point);
+    max = glm::max(max, point);
+}
+
+void Aabb::Grow(const Aabb& other)
+{
+    min = glm::min(min, other.min);
+    max = glm::max(max, other.max);
+}
+
+glm::vec3 Aabb::Center() const
+{
+    return (min + max) * 0.5f;
+}
+
+float Aabb::SurfaceArea() const
+{
+    glm::vec3 e = max - min;
+    return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+}
+
+bool Aabb::IsValid() const
+{
+    return min.x <= max.x && min.y <= max.y && min.z <= max.z;
+}
+
+bool Collision::AabbOverlapsAabb(const Aabb& a, const Aabb& b)
+{
+    return a.min.x <= b.max.x && b.min.x <= a.max.x
+        && a.min.y <= b.max.y && b.min.y <= a.max.y
+        && a.min.z <= b.max.z && b.min.z <= a.max.z;
+}
+
+bool Collision::SphereOverlapsAabb(const Sphere& sphere, const Aabb& box)
+{
+    // closest point on the box, compared in squared distance so no sqrt is needed
+    glm::vec3 closest = glm::clamp(sphere.center, box.min, box.max);
+    glm::vec3 d = sphere.center - closest;
+    return glm::dot(d, d) <= sphere.radius * sphere.radius;
+}
+
+bool Collision::SphereOverlapsSphere(const Sphere& a, const Sphere& b)
+{
+    glm::vec3 d = a.center - b.center;
+    float r = a.radius + b.radius;
+    return glm::dot(d, d) <= r * r;
+}
+
+bool Collision::RayHitsAabb(const Ray& ray, const glm::vec3& invDirection, const Aabb& box, float maxT, float& tNear)
+{
+    glm::vec3 t0 = (box.min - ray.origin) * invDirection;
+    glm::vec3 t1 = (box.max - ray.origin) * invDirection;
+    glm::vec3 tSmall = glm::min(t0, t1);
+    glm::vec3 tBig = glm::max(t0, t1);
+
+    float tEnter = std::max(std::max(tSmall.x, tSmall.y), std::max(tSmall.z, 0.0f));
+    float tExit = std::min(std::min(tBig.x, tBig.y), std::min(tBig.z, maxT));
+    tNear = tEnter;
+    return tEnter <= tExit;
+}
+
+std::vector<Aabb> Collision::LineStripBounds(const std::vector<Vertex>& points, float scale)
+{
+    std::vector<Aabb> bounds;
+    if (points.size() < 2)
+        return bounds;
+
+    bounds.reserve(points.size() - 1);
+    for (size_t i = 0; i + 1 < points.size(); i++)
+    {
+        Aabb box;
+        box.Grow(glm::vec3(points[i].x, points[i].y, points[i].z) * scale);
+        box.Grow(glm::vec3(points[i + 1].x, points[i + 1].y, points[i + 1].z) * scale);
+        bounds.push_back(box);
+    }
+    return bounds;
+}
+
+std::vector<Aabb> Collision::TriangleBounds(const std::vector<Vertex>& vertices, const std::vector<unsigned>& indices, float scale)
+{
+    std::vector<Aabb> bounds;
+    bounds.reserve(indices.size() / 3);
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        Aabb box;
+        for (size_t k = 0; k < 3; k++)
+        {
+            const Vertex& v = vertices[indices[i + k]];
+            box.Grow(glm::vec3(v.x, v.y, v.z) * scale);
+        }
+        bounds.push_back(box);
+    }
+    return bounds;
+}
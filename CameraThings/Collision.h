@@ -0,0 +1,58 @@
+﻿#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/vec3.hpp>
+
+#include "Vertex.h"
+
+/// \brief Axis aligned bounding box
+struct Aabb
+{
+    glm::vec3 min = glm::vec3( 1e30f);
+    glm::vec3 max = glm::vec3(-1e30f);
+
+    void Grow(const glm::vec3& point);
+    void Grow(const Aabb& other);
+    glm::vec3 Center() const;
+    float SurfaceArea() const;
+    bool IsValid() const;
+};
+
+struct Sphere
+{
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+};
+
+/// \brief Two object indices found to (potentially) touch, a < b
+struct CollisionPair
+{
+    uint32_t a;
+    uint32_t b;
+};
+
+/// \brief Ray with a normalised (or at least non-zero) direction
+struct Ray
+{
+    glm::vec3 origin = glm::vec3(0.0f);
+    glm::vec3 direction = glm::vec3(0.0f, 0.0f, -1.0f);
+};
+
+namespace Collision
+{
+    bool AabbOverlapsAabb(const Aabb& a, const Aabb& b);
+    bool SphereOverlapsAabb(const Sphere& sphere, const Aabb& box);
+    bool SphereOverlapsSphere(const Sphere& a, const Sphere& b);
+
+    /// \brief Slab test against a box
+    /// \param invDirection 1 / ray.direction, computed once per ray
+    /// \param tNear entry distance along the ray when the box is hit
+    /// \return true if the box is hit somewhere in [0, maxT]
+    bool RayHitsAabb(const Ray& ray, const glm::vec3& invDirection, const Aabb& box, float maxT, float& tNear);
+
+    /// \brief One box per segment of a line strip, like the curves read by FileManager
+    std::vector<Aabb> LineStripBounds(const std::vector<Vertex>& points, float scale);
+
+    /// \brief One box per indexed triangle of an imported mesh
+    std::vector<Aabb> TriangleBounds(const std::vector<Vertex>& vertices, const std::vector<unsigned>& indices, float scale);
+}
@@ -0,0 +1,155 @@
+﻿#include "CommandBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Profiler.h"
+
+void CommandRecorder::Draw(uint64_t key, MeshHandle mesh, PrimitiveType type, const glm::mat4& model, float size,
+                           size_t first, size_t count)
+{
+    DrawPacket packet;
+    packet.curves = nullptr;
+    packet.mesh = mesh;
+    packet.type = type;
+    packet.size = size;
+    packet.first = static_cast<uint32_t>(first);
+    packet.count = static_cast<uint32_t>(count);
+    Push(key, packet, model);
+}
+
+void CommandRecorder::DrawCurves(uint64_t key, const CurveBatch& batch, const glm::mat4& model, float lineWidth)
+{
+    DrawPacket packet;
+    packet.curves = &batch;
+    packet.mesh = 0;
+    packet.type = PrimitiveType::LineStrip;
+    packet.size = lineWidth;
+    packet.first = 0;
+    packet.count = 0;
+    Push(key, packet, model);
+}
+
+void CommandRecorder::Push(uint64_t key, const DrawPacket& packet, const glm::mat4& model)
+{
+    // consecutive draws with the same matrix share it
+    if (transforms.empty() || std::memcmp(&transforms.back(), &model, sizeof(glm::mat4)) != 0)
+        transforms.push_back(model);
+
+    keys.push_back(key);
+    packets.push_back(packet);
+    packets.back().transform = static_cast<uint32_t>(transforms.size() - 1);
+}
+
+void CommandRecorder::Clear()
+{
+    keys.clear();
+    packets.clear();
+    transforms.clear();
+}
+
+CommandBuffer::CommandBuffer(unsigned recorderCount) : recorders(std::max(recorderCount, 1u))
+{
+}
+
+uint64_t CommandBuffer::MakeKey(RenderPass pass, uint32_t program, MeshHandle mesh, float depth)
+{
+    depth = std::min(std::max(depth, 0.0f), 1.0f);
+    if (pass == RenderPass::Transparent)
+        depth = 1.0f - depth;
+    const uint64_t depthBits = static_cast<uint64_t>(depth * 16777215.0f);
+    return static_cast<uint64_t>(pass) << 56 |
+           static_cast<uint64_t>(program & 0xFFFu) << 44 |
+           static_cast<uint64_t>(mesh & 0xFFFFFu) << 24 |
+           depthBits;
+}
+
+void CommandBuffer::Reset()
+{
+    for (CommandRecorder& recorder : recorders)
+        recorder.Clear();
+}
+
+/// \brief LSD radix sort on bytes, stable, skipping bytes that are the same in every key
+/// (most of them: few passes, programs and meshes)
+void CommandBuffer::Sort()
+{
+    const size_t count = entries.size();
+    uint32_t histograms[8][256] = {};
+    for (const SortEntry& entry : entries)
+    {
+        for (int digit = 0; digit < 8; digit++)
+            histograms[digit][(entry.key >> (digit * 8)) & 0xFF]++;
+    }
+
+    scratch.resize(count);
+    for (int digit = 0; digit < 8; digit++)
+    {
+        uint32_t* histogram = histograms[digit];
+        if (histogram[(entries[0].key >> (digit * 8)) & 0xFF] == count)
+            continue;
+
+        uint32_t offset = 0;
+        for (int bucket = 0; bucket < 256; bucket++)
+        {
+            uint32_t size = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += size;
+        }
+        for (const SortEntry& entry : entries)
+            scratch[histogram[(entry.key >> (digit * 8)) & 0xFF]++] = entry;
+        entries.swap(scratch);
+    }
+}
+
+size_t CommandBuffer::Submit(RenderBackend& backend)
+{
+    PROFILE_SCOPE("Submit");
+    entries.clear();
+    for (uint32_t r = 0; r < recorders.size(); r++)
+    {
+        const CommandRecorder& recorder = recorders[r];
+        for (uint32_t p = 0; p < recorder.keys.size(); p++)
+            entries.push_back(SortEntry{ recorder.keys[p], r, p });
+    }
+    stateChanges = 0;
+    if (entries.empty())
+        return 0;
+    Sort();
+
+    const glm::mat4* model = nullptr;
+    float lineWidth = -1.0f;
+    float pointSize = -1.0f;
+    for (const SortEntry& entry : entries)
+    {
+        const CommandRecorder& recorder = recorders[entry.recorder];
+        const DrawPacket& packet = recorder.packets[entry.packet];
+
+        const glm::mat4* packetModel = &recorder.transforms[packet.transform];
+        if (model == nullptr || (model != packetModel && std::memcmp(model, packetModel, sizeof(glm::mat4)) != 0))
+        {
+            backend.SetModel(*packetModel);
+            stateChanges++;
+        }
+        model = packetModel;
+
+        if (packet.type == PrimitiveType::LineStrip && packet.size != lineWidth)
+        {
+            backend.SetLineWidth(packet.size);
+            lineWidth = packet.size;
+            stateChanges++;
+        }
+        else if (packet.type == PrimitiveType::Points && packet.size != pointSize)
+        {
+            backend.SetPointSize(packet.size);
+            pointSize = packet.size;
+            stateChanges++;
+        }
+
+        if (packet.curves)
+            backend.DrawCurves(*packet.curves);
+        else
+            backend.Draw(packet.mesh, packet.type, packet.first, packet.count);
+    }
+    return entries.size();
+}
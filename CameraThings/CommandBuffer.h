@@ -0,0 +1,95 @@
+﻿#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/mat4x4.hpp>
+
+#include "RenderBackend.h"
+
+class CurveBatch;
+
+/// \brief Coarse ordering of a frame; the top bits of every sort key
+enum class RenderPass : uint8_t
+{
+    Opaque = 0,      // front to back, so the depth test rejects hidden pixels early
+    Transparent = 1, // back to front
+    Overlay = 2
+};
+
+/// \brief One recorded draw. The model matrix lives in the recorder, the packet holds its index.
+struct DrawPacket
+{
+    const CurveBatch* curves; // drawn with DrawCurves instead of the mesh when set
+    MeshHandle mesh;
+    PrimitiveType type;
+    float size; // line width or point size, ignored for triangles
+    uint32_t first;
+    uint32_t count;
+    uint32_t transform;
+};
+
+/// \brief Draws recorded by one thread. Each recording thread uses its own recorder, so
+/// recording needs no locks.
+class CommandRecorder
+{
+public:
+    /// \param key from CommandBuffer::MakeKey
+    void Draw(uint64_t key, MeshHandle mesh, PrimitiveType type, const glm::mat4& model, float size = 1.0f,
+              size_t first = 0, size_t count = 0);
+    /// \brief Every curve of the batch, which must stay alive until the buffer is submitted
+    void DrawCurves(uint64_t key, const CurveBatch& batch, const glm::mat4& model, float lineWidth = 1.0f);
+
+    size_t GetCount() const { return packets.size(); }
+
+private:
+    friend class CommandBuffer;
+
+    std::vector<uint64_t> keys;
+    std::vector<DrawPacket> packets;
+    std::vector<glm::mat4> transforms;
+
+    void Clear();
+    void Push(uint64_t key, const DrawPacket& packet, const glm::mat4& model);
+};
+
+/// \brief A frame's draws, recorded in any order (and on any number of threads), then
+/// radix sorted by a 64-bit key and submitted with as few state changes as possible.
+/// Key layout from the top: pass (8 bits), program (12), mesh (20), depth (24). Packets
+/// with equal keys keep recording order, recorders taken in index order.
+class CommandBuffer
+{
+public:
+    /// \param recorderCount recorders available to GetRecorder, e.g. one per worker thread
+    explicit CommandBuffer(unsigned recorderCount = 1);
+
+    /// \param program caller chosen id of the shader/state group, only the low 12 bits count
+    /// \param depth view distance scaled to 0..1; reversed for the transparent pass
+    static uint64_t MakeKey(RenderPass pass, uint32_t program, MeshHandle mesh, float depth);
+
+    CommandRecorder& GetRecorder(unsigned index = 0) { return recorders[index]; }
+    unsigned GetRecorderCount() const { return static_cast<unsigned>(recorders.size()); }
+
+    /// \brief Drops everything recorded; call once per frame before recording
+    void Reset();
+
+    /// \brief Merges the recorders, sorts and draws everything in key order
+    /// \return number of draws issued
+    size_t Submit(RenderBackend& backend);
+
+    /// \brief Model, line width and point size changes the last Submit made
+    size_t GetStateChanges() const { return stateChanges; }
+
+private:
+    struct SortEntry
+    {
+        uint64_t key;
+        uint32_t recorder;
+        uint32_t packet;
+    };
+
+    std::vector<CommandRecorder> recorders;
+    std::vector<SortEntry> entries;
+    std::vector<SortEntry> scratch;
+    size_t stateChanges = 0;
+
+    void Sort();
+};
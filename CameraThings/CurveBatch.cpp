@@ -0,0 +1,46 @@
+﻿#include "CurveBatch.h"
+
+#include <atomic>
+
+namespace
+{
+    std::atomic<uint32_t> nextId(1);
+}
+
+CurveBatch::CurveBatch() : id(nextId++)
+{
+}
+
+uint32_t CurveBatch::Add(const std::vector<glm::vec3>& curvePoints, const glm::vec4& color, const glm::mat4& transform)
+{
+    Curve curve;
+    curve.first = static_cast<uint32_t>(points.size());
+    curve.count = static_cast<uint32_t>(curvePoints.size());
+    curve.transform = transform;
+    curve.color = color;
+    points.insert(points.end(), curvePoints.begin(), curvePoints.end());
+    curves.push_back(curve);
+    pointsVersion++;
+    curvesVersion++;
+    return static_cast<uint32_t>(curves.size() - 1);
+}
+
+void CurveBatch::SetTransform(uint32_t curve, const glm::mat4& transform)
+{
+    curves[curve].transform = transform;
+    curvesVersion++;
+}
+
+void CurveBatch::SetColor(uint32_t curve, const glm::vec4& color)
+{
+    curves[curve].color = color;
+    curvesVersion++;
+}
+
+void CurveBatch::Clear()
+{
+    points.clear();
+    curves.clear();
+    pointsVersion++;
+    curvesVersion++;
+}
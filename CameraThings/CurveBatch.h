@@ -0,0 +1,50 @@
+﻿#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+/// \brief Many independent line strips that a backend draws together: the points of every
+/// curve are stored back to back, and each curve has its own transform and colour, so the
+/// GL backend needs one draw call for the whole batch instead of one per curve.
+class CurveBatch
+{
+public:
+    struct Curve
+    {
+        uint32_t first; // index of the first point
+        uint32_t count;
+        glm::mat4 transform; // applied before the backend's model matrix
+        glm::vec4 color;
+    };
+
+    CurveBatch();
+    // a copy would share the id, and so the backend's GPU copy, with the original
+    CurveBatch(const CurveBatch&) = delete;
+    CurveBatch& operator=(const CurveBatch&) = delete;
+
+    /// \return index of the new curve
+    uint32_t Add(const std::vector<glm::vec3>& points, const glm::vec4& color, const glm::mat4& transform = glm::mat4(1.0f));
+    void SetTransform(uint32_t curve, const glm::mat4& transform);
+    void SetColor(uint32_t curve, const glm::vec4& color);
+    void Clear();
+
+    size_t GetCurveCount() const { return curves.size(); }
+    const std::vector<Curve>& GetCurves() const { return curves; }
+    const std::vector<glm::vec3>& GetPoints() const { return points; }
+
+    /// \brief Unique per batch, for backends that keep a GPU copy
+    uint32_t GetId() const { return id; }
+    /// \brief Changes whenever curves are added or cleared
+    uint64_t GetPointsVersion() const { return pointsVersion; }
+    /// \brief Changes whenever a transform or colour changes, or curves are added or cleared
+    uint64_t GetCurvesVersion() const { return curvesVersion; }
+
+private:
+    uint32_t id;
+    std::vector<glm::vec3> points;
+    std::vector<Curve> curves;
+    uint64_t pointsVersion = 1;
+    uint64_t curvesVersion = 1;
+};
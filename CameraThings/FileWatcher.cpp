@@ -0,0 +1,127 @@
+﻿#include "FileWatcher.h"
+
+#include <algorithm>
+#include <iostream>
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    int64_t ModifiedTime(const std::string& path)
+    {
+#ifdef _WIN32
+        struct _stat64 info;
+        return _stat64(path.c_str(), &info) == 0 ? static_cast<int64_t>(info.st_mtime) : -1;
+#else
+        struct stat info;
+        return stat(path.c_str(), &info) == 0 ? static_cast<int64_t>(info.st_mtime) : -1;
+#endif
+    }
+}
+
+FileWatcher::FileWatcher()
+{
+#ifdef __linux__
+    inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify < 0)
+        std::cout << "WARNING::FILEWATCHER::INOTIFY_UNAVAILABLE" << std::endl;
+#endif
+}
+
+FileWatcher::~FileWatcher()
+{
+#ifdef __linux__
+    if (inotify >= 0)
+        close(inotify);
+#endif
+}
+
+void FileWatcher::Watch(const std::string& path)
+{
+    for (const WatchedFile& file : files)
+    {
+        if (file.path == path)
+            return;
+    }
+
+    WatchedFile file;
+    file.path = path;
+    size_t slash = path.find_last_of("/\\");
+    file.directory = slash == std::string::npos ? std::string(".") : path.substr(0, slash);
+    file.name = slash == std::string::npos ? path : path.substr(slash + 1);
+    file.modified = ModifiedTime(path);
+    files.push_back(file);
+
+#ifdef __linux__
+    if (inotify < 0)
+        return;
+    for (const auto& directory : directories)
+    {
+        if (directory.second == file.directory)
+            return;
+    }
+    int descriptor = inotify_add_watch(inotify, file.directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (descriptor < 0)
+        std::cout << "WARNING::FILEWATCHER::CANNOT_WATCH " << file.directory << std::endl;
+    else
+        directories.emplace_back(descriptor, file.directory);
+#endif
+}
+
+bool FileWatcher::Poll(std::vector<std::string>& changed)
+{
+    changed.clear();
+#ifdef __linux__
+    if (inotify < 0)
+        return false;
+
+    alignas(inotify_event) char buffer[4096];
+    for (;;)
+    {
+        ssize_t length = read(inotify, buffer, sizeof(buffer));
+        if (length <= 0)
+            break;
+        for (ssize_t offset = 0; offset < length;)
+        {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += sizeof(inotify_event) + event->len;
+            if (event->len == 0)
+                continue;
+
+            const std::string* directory = nullptr;
+            for (const auto& entry : directories)
+            {
+                if (entry.first == event->wd)
+                    directory = &entry.second;
+            }
+            for (const WatchedFile& file : files)
+            {
+                if (directory && file.directory == *directory && file.name == event->name &&
+                    std::find(changed.begin(), changed.end(), file.path) == changed.end())
+                    changed.push_back(file.path);
+            }
+        }
+    }
+#else
+    // file times are only worth asking for a few times per second
+    auto now = std::chrono::steady_clock::now();
+    if (now - lastCheck < std::chrono::milliseconds(250))
+        return false;
+    lastCheck = now;
+
+    for (WatchedFile& file : files)
+    {
+        int64_t modified = ModifiedTime(file.path);
+        if (modified != file.modified && modified != -1)
+        {
+            file.modified = modified;
+            changed.push_back(file.path);
+        }
+    }
+#endif
+    return !changed.empty();
+}
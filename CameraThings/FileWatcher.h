@@ -0,0 +1,42 @@
+﻿#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// \brief Reports files that were written since the last Poll. Uses inotify on Linux
+/// (watching the containing directories, since editors often save by renaming a new file
+/// over the old one); elsewhere it compares modification times a few times per second.
+class FileWatcher
+{
+public:
+    FileWatcher();
+    ~FileWatcher();
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    /// \brief Adds a file; watching the same path twice does nothing
+    void Watch(const std::string& path);
+
+    /// \brief Never blocks
+    /// \param changed receives each changed watched path once
+    /// \return true if anything changed
+    bool Poll(std::vector<std::string>& changed);
+
+private:
+    struct WatchedFile
+    {
+        std::string path;
+        std::string directory;
+        std::string name;
+        int64_t modified; // polling fallback only
+    };
+
+    std::vector<WatchedFile> files;
+#ifdef __linux__
+    int inotify = -1;
+    std::vector<std::pair<int, std::string>> directories; // watch descriptor, directory
+#else
+    std::chrono::steady_clock::time_point lastCheck;
+#endif
+};
@@ -0,0 +1,310 @@
+﻿#include "FrameStats.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <glad/glad.h>
+
+namespace
+{
+    unsigned HighestBit(uint64_t value)
+    {
+        unsigned bit = 0;
+        while (value >>= 1)
+            bit++;
+        return bit;
+    }
+
+    uint64_t Microseconds(std::chrono::steady_clock::duration duration)
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+    }
+}
+
+FrameHistogram::FrameHistogram()
+    : counts(IndexOf((uint64_t(1) << MaxBits) - 1) + 1, 0)
+{
+}
+
+// below SubBuckets every value has its own bucket; above, each power of two
+// [2^b, 2^(b+1)) gets SubBuckets / 2 buckets of equal width
+size_t FrameHistogram::IndexOf(uint64_t value)
+{
+    if (value < SubBuckets)
+        return static_cast<size_t>(value);
+    const unsigned shift = HighestBit(value) - (SubBucketBits - 1);
+    const uint64_t sub = value >> shift; // SubBuckets / 2 .. SubBuckets - 1
+    return static_cast<size_t>(SubBuckets + (shift - 1) * (SubBuckets / 2) + (sub - SubBuckets / 2));
+}
+
+uint64_t FrameHistogram::HighestValueAt(size_t index)
+{
+    if (index < SubBuckets)
+        return index;
+    const uint64_t offset = index - SubBuckets;
+    const unsigned shift = static_cast<unsigned>(offset / (SubBuckets / 2)) + 1;
+    const uint64_t sub = offset % (SubBuckets / 2) + SubBuckets / 2;
+    return ((sub + 1) << shift) - 1;
+}
+
+void FrameHistogram::Record(uint64_t microseconds)
+{
+    const uint64_t value = std::min(microseconds, (uint64_t(1) << MaxBits) - 1);
+    counts[IndexOf(value)]++;
+    count++;
+    total += value;
+    min = std::min(min, value);
+    max = std::max(max, value);
+}
+
+void FrameHistogram::Add(const FrameHistogram& other)
+{
+    for (size_t i = 0; i < counts.size(); i++)
+        counts[i] += other.counts[i];
+    count += other.count;
+    total += other.total;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+}
+
+void FrameHistogram::Reset()
+{
+    std::fill(counts.begin(), counts.end(), 0);
+    count = 0;
+    total = 0;
+    min = UINT64_MAX;
+    max = 0;
+}
+
+uint64_t FrameHistogram::GetPercentile(double percentile) const
+{
+    if (count == 0)
+        return 0;
+    // rank of the sample, 1-based, so p0 is the smallest and p100 the largest
+    const double clamped = std::min(std::max(percentile, 0.0), 100.0);
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(clamped / 100.0 * double(count) + 0.5));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); i++)
+    {
+        seen += counts[i];
+        if (seen >= rank)
+            return std::min(HighestValueAt(i), max);
+    }
+    return max;
+}
+
+uint64_t FrameHistogram::CountAbove(uint64_t microseconds) const
+{
+    uint64_t above = 0;
+    for (size_t i = IndexOf(std::min(microseconds, (uint64_t(1) << MaxBits) - 1)) + 1; i < counts.size(); i++)
+        above += counts[i];
+    return above;
+}
+
+void FrameStats::Start(bool gpu)
+{
+    gpuEnabled = gpu;
+    if (gpuEnabled)
+    {
+        for (GpuFrame& frame : gpuFrames)
+            glGenQueries(2, frame.queries);
+    }
+    runStart = Clock::now();
+    runEnd = runStart;
+    intervalStart = runStart;
+}
+
+bool FrameStats::OpenCsv(const std::string& path)
+{
+    csv.open(path);
+    if (!csv)
+    {
+        std::cout << "ERROR::FRAME_STATS::FILE_NOT_WRITABLE " << path << std::endl;
+        return false;
+    }
+    csv << "frame,cpu_ms,gpu_ms\n" << std::fixed << std::setprecision(3);
+    return true;
+}
+
+void FrameStats::BeginFrame()
+{
+    frameStart = Clock::now();
+    if (gpuEnabled)
+    {
+        GpuFrame& frame = gpuFrames[gpuFrame];
+        // the slot is FrameLatency frames old, its timestamps are normally long done
+        ReadGpuFrame(frame, true);
+        glQueryCounter(frame.queries[0], GL_TIMESTAMP);
+    }
+}
+
+void FrameStats::EndFrame()
+{
+    if (waitForGpu && gpuEnabled)
+    {
+        GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) // 1 s
+            ;
+        glDeleteSync(fence);
+    }
+    const Clock::time_point now = Clock::now();
+    const uint64_t cpuMicroseconds = Microseconds(now - frameStart);
+    const uint64_t frame = frameCount++;
+    cpu.Record(cpuMicroseconds);
+    intervalCpu.Record(cpuMicroseconds);
+
+    if (gpuEnabled)
+    {
+        GpuFrame& slot = gpuFrames[gpuFrame];
+        glQueryCounter(slot.queries[1], GL_TIMESTAMP);
+        slot.frame = frame;
+        slot.cpuMicroseconds = cpuMicroseconds;
+        slot.pending = true;
+        gpuFrame = (gpuFrame + 1) % FrameLatency;
+        // oldest first, and no frame before an older one, so the CSV stays in frame order
+        for (unsigned i = 0; i < FrameLatency; i++)
+        {
+            if (!ReadGpuFrame(gpuFrames[(gpuFrame + i) % FrameLatency], false))
+                break;
+        }
+    }
+    else
+    {
+        Write(frame, cpuMicroseconds, nullptr);
+    }
+
+    if (reportInterval > 0.0 && std::chrono::duration<double>(now - intervalStart).count() >= reportInterval)
+    {
+        PrintLine(std::cout, "CPU frame", intervalCpu);
+        if (gpuEnabled && intervalGpu.GetCount() > 0)
+            PrintLine(std::cout, "GPU frame", intervalGpu);
+        intervalCpu.Reset();
+        intervalGpu.Reset();
+        intervalStart = now;
+    }
+}
+
+bool FrameStats::ReadGpuFrame(GpuFrame& frame, bool wait)
+{
+    if (!frame.pending)
+        return true;
+    if (!wait)
+    {
+        GLint available = 0;
+        glGetQueryObjectiv(frame.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            return false;
+    }
+    GLuint64 begin = 0, end = 0;
+    glGetQueryObjectui64v(frame.queries[0], GL_QUERY_RESULT, &begin);
+    glGetQueryObjectui64v(frame.queries[1], GL_QUERY_RESULT, &end);
+    const uint64_t gpuMicroseconds = end > begin ? (end - begin) / 1000 : 0;
+    gpu.Record(gpuMicroseconds);
+    intervalGpu.Record(gpuMicroseconds);
+    Write(frame.frame, frame.cpuMicroseconds, &gpuMicroseconds);
+    frame.pending = false;
+    return true;
+}
+
+void FrameStats::Write(uint64_t frame, uint64_t cpuMicroseconds, const uint64_t* gpuMicroseconds)
+{
+    if (!csv.is_open())
+        return;
+    csv << frame << ',' << double(cpuMicroseconds) / 1000.0 << ',';
+    if (gpuMicroseconds)
+        csv << double(*gpuMicroseconds) / 1000.0;
+    csv << '\n';
+}
+
+void FrameStats::Finish()
+{
+    runEnd = Clock::now();
+    if (gpuEnabled)
+    {
+        // oldest first, so the CSV stays in frame order
+        for (unsigned i = 0; i < FrameLatency; i++)
+            ReadGpuFrame(gpuFrames[(gpuFrame + i) % FrameLatency], true);
+        for (GpuFrame& frame : gpuFrames)
+            glDeleteQueries(2, frame.queries);
+    }
+    if (csv.is_open())
+        csv.close();
+}
+
+void FrameStats::PrintSummary(std::ostream& out) const
+{
+    if (cpu.GetCount() == 0)
+        return;
+    PrintLine(out, "CPU frame", cpu);
+    if (gpuEnabled && gpu.GetCount() > 0)
+        PrintLine(out, "GPU frame", gpu);
+}
+
+bool FrameStats::WriteJson(const std::string& path, const std::map<std::string, std::string>& run) const
+{
+    std::ofstream out(path);
+    if (!out)
+    {
+        std::cout << "ERROR::FRAME_STATS::FILE_NOT_WRITABLE " << path << std::endl;
+        return false;
+    }
+
+    const double seconds = std::chrono::duration<double>(runEnd - runStart).count();
+    out << "{\n  \"run\": {";
+    bool first = true;
+    for (const auto& entry : run)
+    {
+        out << (first ? "" : ",") << "\n    \"" << entry.first << "\": \"";
+        for (char c : entry.second)
+        {
+            if (c == '"' || c == '\\')
+                out << '\\';
+            out << c;
+        }
+        out << '"';
+        first = false;
+    }
+    out << "\n  },\n" << std::fixed << std::setprecision(3)
+        << "  \"seconds\": " << seconds << ",\n"
+        << "  \"frames\": " << cpu.GetCount() << ",\n"
+        << "  \"fps\": " << (seconds > 0.0 ? double(cpu.GetCount()) / seconds : 0.0) << ",\n"
+        << "  \"cpu\": ";
+    WriteHistogram(out, cpu);
+    out << ",\n  \"gpu\": ";
+    if (gpuEnabled)
+        WriteHistogram(out, gpu);
+    else
+        out << "null";
+    out << "\n}\n";
+    std::cout << "Benchmark report written to " << path << std::endl;
+    return static_cast<bool>(out);
+}
+
+void FrameStats::WriteHistogram(std::ostream& out, const FrameHistogram& histogram)
+{
+    out << "{ \"count\": " << histogram.GetCount()
+        << ", \"mean_ms\": " << histogram.GetMean() / 1000.0
+        << ", \"p50_ms\": " << histogram.GetPercentile(50.0) / 1000.0
+        << ", \"p90_ms\": " << histogram.GetPercentile(90.0) / 1000.0
+        << ", \"p95_ms\": " << histogram.GetPercentile(95.0) / 1000.0
+        << ", \"p99_ms\": " << histogram.GetPercentile(99.0) / 1000.0
+        << ", \"p999_ms\": " << histogram.GetPercentile(99.9) / 1000.0
+        << ", \"max_ms\": " << histogram.GetMax() / 1000.0 << " }";
+}
+
+void FrameStats::PrintLine(std::ostream& out, const char* label, const FrameHistogram& histogram)
+{
+    // a hitch is a frame that took more than twice the median
+    const uint64_t median = histogram.GetPercentile(50.0);
+    const std::ios::fmtflags flags = out.flags();
+    const std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(2)
+        << label << ": " << histogram.GetCount() << " frames, mean " << histogram.GetMean() / 1000.0
+        << " ms, p50 " << median / 1000.0
+        << ", p95 " << histogram.GetPercentile(95.0) / 1000.0
+        << ", p99 " << histogram.GetPercentile(99.0) / 1000.0
+        << ", max " << histogram.GetMax() / 1000.0
+        << " ms, " << histogram.CountAbove(median * 2) << " hitches" << std::endl;
+    out.flags(flags);
+    out.precision(precision);
+}
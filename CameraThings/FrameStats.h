@@ -0,0 +1,121 @@
+﻿#pragma once
+#include <cstdint>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/// \brief HDR-style histogram of durations in microseconds. Every power of two is split into
+/// the same number of linear buckets, so a recorded value comes back within 1/128 of itself
+/// anywhere from 1 us to over an hour, in a fixed few KB of counters.
+class FrameHistogram
+{
+public:
+    FrameHistogram();
+
+    void Record(uint64_t microseconds);
+    void Add(const FrameHistogram& other);
+    void Reset();
+
+    uint64_t GetCount() const { return count; }
+    uint64_t GetMin() const { return count ? min : 0; }
+    uint64_t GetMax() const { return max; }
+    double GetMean() const { return count ? double(total) / double(count) : 0.0; }
+
+    /// \param percentile 0..100
+    /// \return the largest value that falls in the same bucket as the percentile's sample
+    uint64_t GetPercentile(double percentile) const;
+
+    /// \brief Samples longer than the given time, within bucket precision
+    uint64_t CountAbove(uint64_t microseconds) const;
+
+private:
+    static const unsigned SubBucketBits = 8;
+    static const uint64_t SubBuckets = uint64_t(1) << SubBucketBits;
+    static const unsigned MaxBits = 32; // larger values are clamped
+
+    std::vector<uint64_t> counts;
+    uint64_t count = 0;
+    uint64_t total = 0;
+    uint64_t min = UINT64_MAX;
+    uint64_t max = 0;
+
+    static size_t IndexOf(uint64_t value);
+    static uint64_t HighestValueAt(size_t index);
+};
+
+/// \brief CPU and GPU time of every frame of the render loop. CPU time is the wall time from
+/// BeginFrame to EndFrame. GPU time is the distance between GL_TIMESTAMP queries issued at the
+/// same two points, read back FrameLatency frames later so it never stalls the loop; timestamp
+/// queries can overlap the profiler's GL_TIME_ELAPSED scopes.
+class FrameStats
+{
+public:
+    static const unsigned FrameLatency = 4;
+
+    /// \param gpu also time the GPU; needs a current GL context from here on
+    void Start(bool gpu);
+
+    /// \brief Writes frame,cpu_ms,gpu_ms per frame; rows of GPU-timed runs lag by FrameLatency
+    /// \return false if the file could not be created
+    bool OpenCsv(const std::string& path);
+
+    /// \brief Prints a summary of the last interval this often while running, 0 only at the end
+    void SetReportInterval(double seconds) { reportInterval = seconds; }
+
+    /// \brief Makes EndFrame wait on a fence until the GPU has finished the frame, so CPU time
+    /// is the full time to a completed frame instead of the time to queue it. For benchmarks;
+    /// it removes the overlap between frames that a normal run relies on.
+    void SetWaitForGpu(bool wait) { waitForGpu = wait; }
+
+    void BeginFrame();
+    void EndFrame();
+
+    /// \brief Waits for the GPU times still in flight, closes the CSV and frees the queries
+    void Finish();
+
+    void PrintSummary(std::ostream& out) const;
+
+    /// \brief Writes the run as JSON: the given strings under "run", wall time, frame rate,
+    /// and count, mean, p50, p90, p95, p99, p99.9 and max in ms for "cpu" and "gpu"
+    /// \return false if the file could not be written
+    bool WriteJson(const std::string& path, const std::map<std::string, std::string>& run) const;
+
+    const FrameHistogram& GetCpu() const { return cpu; }
+    const FrameHistogram& GetGpu() const { return gpu; }
+    bool HasGpu() const { return gpuEnabled; }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    /// \brief Timestamps of one frame, reused FrameLatency frames later
+    struct GpuFrame
+    {
+        unsigned queries[2] = { 0, 0 };
+        uint64_t frame = 0;
+        uint64_t cpuMicroseconds = 0;
+        bool pending = false;
+    };
+
+    FrameHistogram cpu, gpu;
+    FrameHistogram intervalCpu, intervalGpu;
+    std::ofstream csv;
+    double reportInterval = 0.0;
+    Clock::time_point runStart, runEnd;
+    Clock::time_point intervalStart;
+    Clock::time_point frameStart;
+    uint64_t frameCount = 0;
+
+    bool gpuEnabled = false;
+    bool waitForGpu = false;
+    GpuFrame gpuFrames[FrameLatency];
+    unsigned gpuFrame = 0;
+
+    /// \return false if the frame's times are not there yet (only without wait)
+    bool ReadGpuFrame(GpuFrame& frame, bool wait);
+    void Write(uint64_t frame, uint64_t cpuMicroseconds, const uint64_t* gpuMicroseconds);
+    static void PrintLine(std::ostream& out, const char* label, const FrameHistogram& histogram);
+    static void WriteHistogram(std::ostream& out, const FrameHistogram& histogram);
+};
@@ -0,0 +1,47 @@
+﻿#include "Frustum.h"
+
+#include <glm/geometric.hpp>
+
+void Frustum::FromMatrix(const glm::mat4& viewProjection)
+{
+    // glm is column major, so row i of the matrix is (m[0][i], m[1][i], m[2][i], m[3][i])
+    const glm::mat4& m = viewProjection;
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    planes[0] = row3 + row0;
+    planes[1] = row3 - row0;
+    planes[2] = row3 + row1;
+    planes[3] = row3 - row1;
+    planes[4] = row3 + row2;
+    planes[5] = row3 - row2;
+
+    for (glm::vec4& plane : planes)
+        plane /= glm::length(glm::vec3(plane));
+}
+
+bool Frustum::Intersects(const Aabb& box) const
+{
+    for (const glm::vec4& plane : planes)
+    {
+        // the box corner furthest along the plane normal
+        glm::vec3 corner(plane.x >= 0.0f ? box.max.x : box.min.x,
+                         plane.y >= 0.0f ? box.max.y : box.min.y,
+                         plane.z >= 0.0f ? box.max.z : box.min.z);
+        if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+bool Frustum::Intersects(const Sphere& sphere) const
+{
+    for (const glm::vec4& plane : planes)
+    {
+        if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,17 @@
+﻿#pragma once
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
+
+#include "Collision.h"
+
+/// \brief The six planes of a view frustum, pointing inwards (left, right, bottom, top, near, far)
+struct Frustum
+{
+    glm::vec4 planes[6];
+
+    /// \brief Extracts the planes from projection * view (Gribb/Hartmann)
+    void FromMatrix(const glm::mat4& viewProjection);
+
+    bool Intersects(const Aabb& box) const;
+    bool Intersects(const Sphere& sphere) const;
+};
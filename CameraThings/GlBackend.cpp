@@ -0,0 +1,470 @@
+﻿#include "GlBackend.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <glad/glad.h>
+
+#include "CurveBatch.h"
+#include "GlState.h"
+#include "Shader.h"
+
+namespace
+{
+    constexpr UniformHandle ModelUniform = Shader::Uniform("model");
+    constexpr UniformHandle CurveDataUniform = Shader::Uniform("curveData");
+    constexpr UniformHandle LineVerticesUniform = Shader::Uniform("lineVertices");
+    constexpr UniformHandle LineFirstUniform = Shader::Uniform("lineFirst");
+    constexpr UniformHandle LineLastUniform = Shader::Uniform("lineLast");
+    constexpr UniformHandle LineWidthUniform = Shader::Uniform("lineWidth");
+    constexpr UniformHandle LineJoinUniform = Shader::Uniform("lineJoin");
+    constexpr UniformHandle ViewportSizeUniform = Shader::Uniform("viewportSize");
+    constexpr UniformHandle SplatSizeUniform = Shader::Uniform("splatSize");
+    constexpr UniformHandle ViewportHeightUniform = Shader::Uniform("viewportHeight");
+    constexpr UniformHandle MaxPointSizeUniform = Shader::Uniform("maxPointSize");
+    constexpr UniformHandle SplatPassUniform = Shader::Uniform("splatPass");
+    constexpr UniformHandle SplatDepthOffsetUniform = Shader::Uniform("splatDepthOffset");
+    constexpr UniformHandle SplatColorUniform = Shader::Uniform("splatColor");
+    constexpr UniformHandle SplatDepthUniform = Shader::Uniform("splatDepth");
+    const int CurveDataUnit = 0;
+    const int LineVerticesUnit = 1;
+    const int SplatColorUnit = 0;
+    const int SplatDepthUnit = 1;
+
+    // splatPass values in Splat.vert
+    const int SplatOpaquePass = 0;
+    const int SplatVisibilityPass = 1;
+    const int SplatAccumulationPass = 2;
+
+    GLenum ToGl(PrimitiveType type)
+    {
+        switch (type)
+        {
+        case PrimitiveType::Points: return GL_POINTS;
+        case PrimitiveType::LineStrip: return GL_LINE_STRIP;
+        default: return GL_TRIANGLES;
+        }
+    }
+
+    const GLsizei Stride = static_cast<GLsizei>(RenderBackend::FloatsPerVertex * sizeof(float));
+
+    struct CurveVertex
+    {
+        glm::vec3 position;
+        uint32_t curve; // index into curveData
+    };
+
+    /// \brief Position and colour attributes of the bound vertex array, from the bound array buffer
+    void SetVertexAttributes(size_t offset)
+    {
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, Stride, (void*)offset);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, Stride, (void*)(offset + 3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+    }
+}
+
+GlBackend::GlBackend(const Programs& programs, GlState& state) : programs(programs), state(state), model(1.0f)
+{
+    cameraUniforms.Create();
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTextureBufferSize);
+    glGenVertexArrays(1, &emptyVertexArray);
+    float pointSizeRange[2] = { 1.0f, 1.0f };
+    glGetFloatv(GL_POINT_SIZE_RANGE, pointSizeRange);
+    maxPointSize = pointSizeRange[1];
+}
+
+GlBackend::~GlBackend()
+{
+    for (size_t i = 0; i < meshes.size(); i++)
+        DestroyMesh(static_cast<MeshHandle>(i + 1));
+    for (auto& entry : curveBatches)
+    {
+        CurveBuffers& buffers = entry.second;
+        glDeleteVertexArrays(1, &buffers.vertexArray);
+        glDeleteBuffers(1, &buffers.vertexBuffer);
+        glDeleteBuffers(1, &buffers.curveBuffer);
+        glDeleteTextures(1, &buffers.curveTexture);
+        glDeleteTextures(1, &buffers.lineTexture);
+    }
+    glDeleteTextures(1, &streamTexture);
+    glDeleteVertexArrays(1, &emptyVertexArray);
+    splatBuffer.Destroy();
+    stream.Destroy();
+    cameraUniforms.Destroy();
+}
+
+MeshHandle GlBackend::CreateMesh(const float* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount, bool dynamic)
+{
+    Mesh mesh;
+    mesh.vertexCount = vertexCount;
+    mesh.indexCount = indices ? indexCount : 0;
+    mesh.dynamic = dynamic;
+
+    glGenVertexArrays(1, &mesh.vertexArray);
+    state.BindVertexArray(mesh.vertexArray);
+    if (mesh.indexCount > 0)
+    {
+        glGenBuffers(1, &mesh.indexBuffer);
+        state.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(uint32_t), indices, GL_STATIC_DRAW);
+    }
+
+    if (dynamic)
+    {
+        // room for every dynamic mesh, each aligned to the vertex size
+        streamBytes += (vertexCount + 1) * Stride;
+        if (streamBytes > stream.GetRegionBytes() && !stream.Create(streamBytes * 2))
+            std::cout << "ERROR::GLBACKEND::STREAM_BUFFER_NOT_CREATED" << std::endl;
+    }
+    else
+    {
+        glGenBuffers(1, &mesh.vertexBuffer);
+        state.BindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffer);
+        glBufferData(GL_ARRAY_BUFFER, vertexCount * Stride, vertices, GL_STATIC_DRAW);
+        SetVertexAttributes(0);
+    }
+
+    meshes.push_back(mesh);
+    const MeshHandle handle = static_cast<MeshHandle>(meshes.size());
+    if (dynamic && vertices)
+        UpdateMesh(handle, vertices, vertexCount);
+    return handle;
+}
+
+void GlBackend::UpdateMesh(MeshHandle handle, const float* vertices, size_t vertexCount)
+{
+    Mesh& mesh = meshes[handle - 1];
+    vertexCount = std::min(vertexCount, mesh.vertexCount);
+    if (!mesh.dynamic)
+    {
+        state.BindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffer);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, vertexCount * Stride, vertices);
+        return;
+    }
+
+    size_t offset = 0;
+    if (!stream.Write(vertices, vertexCount * Stride, Stride, offset))
+    {
+        std::cout << "ERROR::GLBACKEND::STREAM_BUFFER_FULL" << std::endl;
+        return;
+    }
+    mesh.streamOffset = offset;
+    mesh.streamCount = vertexCount;
+    mesh.streamFrame = stream.GetFrame();
+}
+
+void GlBackend::DestroyMesh(MeshHandle handle)
+{
+    Mesh& mesh = meshes[handle - 1];
+    if (mesh.vertexArray == 0)
+        return;
+    glDeleteVertexArrays(1, &mesh.vertexArray);
+    if (mesh.vertexBuffer)
+        glDeleteBuffers(1, &mesh.vertexBuffer);
+    if (mesh.indexBuffer)
+        glDeleteBuffers(1, &mesh.indexBuffer);
+    if (mesh.lineTexture)
+        glDeleteTextures(1, &mesh.lineTexture);
+    mesh = Mesh();
+    state.Invalidate(); // the deleted names may come back for new objects
+}
+
+void GlBackend::BeginFrame(const Camera& camera, const glm::vec4& clearColor)
+{
+    Use(programs.scene);
+    // one upload shared by every program, skipped while the camera is still
+    cameraUniforms.Update(camera);
+    state.ClearColor(clearColor.r, clearColor.g, clearColor.b, clearColor.a);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &frameTarget);
+    viewportSize = glm::vec2(viewport[2], viewport[3]);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void GlBackend::SetModel(const glm::mat4& model)
+{
+    this->model = model;
+    modelProgram = 0; // uploaded by Use to whichever program draws next
+}
+
+void GlBackend::SetLineWidth(float width)
+{
+    // GL lines stay at the 1 pixel every driver supports, anything wider is drawn as quads
+    lineWidth = width;
+}
+
+void GlBackend::SetPointSize(float size)
+{
+    pointSize = size;
+    state.PointSize(size);
+}
+
+void GlBackend::Draw(MeshHandle handle, PrimitiveType type, size_t first, size_t count)
+{
+    Mesh& mesh = meshes[handle - 1];
+    if (mesh.dynamic && mesh.streamFrame != stream.GetFrame())
+        return; // not updated this frame, its vertices may already be overwritten
+    const size_t vertexCount = mesh.dynamic ? mesh.streamCount : mesh.vertexCount;
+    const size_t total = mesh.indexCount > 0 ? mesh.indexCount : vertexCount;
+    if (first >= total)
+        return;
+    if (count == 0 || first + count > total)
+        count = total - first;
+
+    const size_t base = mesh.dynamic ? mesh.streamOffset / Stride : 0;
+    const size_t lineTexels = (base + first + count) * FloatsPerVertex;
+    if (type == PrimitiveType::LineStrip && lineWidth > 1.0f && programs.lines && mesh.indexCount == 0 &&
+        lineTexels <= static_cast<size_t>(maxTextureBufferSize))
+    {
+        unsigned texture;
+        if (mesh.dynamic)
+        {
+            if (streamTextureBuffer != stream.GetBuffer())
+            {
+                glDeleteTextures(1, &streamTexture);
+                streamTexture = CreateBufferTexture(stream.GetBuffer(), GL_R32F);
+                streamTextureBuffer = stream.GetBuffer();
+            }
+            texture = streamTexture;
+        }
+        else
+        {
+            if (mesh.lineTexture == 0)
+                mesh.lineTexture = CreateBufferTexture(mesh.vertexBuffer, GL_R32F);
+            texture = mesh.lineTexture;
+        }
+        DrawWideLines(programs.lines, texture, static_cast<int>(base + first), static_cast<int>(base + first + count - 1));
+        return;
+    }
+
+    const bool splats = type == PrimitiveType::Points && pointMode != PointMode::Square && programs.splats;
+    Use(splats ? programs.splats : programs.scene);
+    state.BindVertexArray(mesh.vertexArray);
+    if (mesh.dynamic)
+    {
+        // the vertices move around the ring every frame
+        state.BindBuffer(GL_ARRAY_BUFFER, stream.GetBuffer());
+        SetVertexAttributes(mesh.streamOffset);
+    }
+    if (splats)
+        DrawSplats(mesh, first, count);
+    else if (mesh.indexCount > 0)
+        glDrawElements(ToGl(type), (GLsizei)count, GL_UNSIGNED_INT, (void*)(first * sizeof(uint32_t)));
+    else
+        glDrawArrays(ToGl(type), (GLint)first, (GLsizei)count);
+}
+
+void GlBackend::DrawCurves(const CurveBatch& batch)
+{
+    if (programs.curves == nullptr || batch.GetCurveCount() == 0)
+        return;
+
+    CurveBuffers& buffers = curveBatches[batch.GetId()];
+    UploadCurves(batch, buffers);
+
+    glActiveTexture(GL_TEXTURE0 + CurveDataUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, buffers.curveTexture);
+    const size_t pointCount = batch.GetPoints().size();
+    if (lineWidth > 1.0f && programs.curveLines && pointCount <= static_cast<size_t>(maxTextureBufferSize))
+    {
+        Use(programs.curveLines);
+        programs.curveLines->SetInt(CurveDataUniform, CurveDataUnit);
+        // the segments of every curve in one instanced draw; those bridging two curves are dropped
+        DrawWideLines(programs.curveLines, buffers.lineTexture, 0, static_cast<int>(pointCount - 1));
+        return;
+    }
+
+    Use(programs.curves);
+    programs.curves->SetInt(CurveDataUniform, CurveDataUnit);
+    state.BindVertexArray(buffers.vertexArray);
+    glMultiDrawArrays(GL_LINE_STRIP, buffers.firsts.data(), buffers.counts.data(), static_cast<GLsizei>(buffers.counts.size()));
+}
+
+/// \brief Brings the GPU copy up to date, uploading only the parts whose version changed
+void GlBackend::UploadCurves(const CurveBatch& batch, CurveBuffers& buffers)
+{
+    if (buffers.vertexArray == 0)
+    {
+        glGenVertexArrays(1, &buffers.vertexArray);
+        glGenBuffers(1, &buffers.vertexBuffer);
+        glGenBuffers(1, &buffers.curveBuffer);
+        glGenTextures(1, &buffers.curveTexture);
+
+        state.BindVertexArray(buffers.vertexArray);
+        state.BindBuffer(GL_ARRAY_BUFFER, buffers.vertexBuffer);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(CurveVertex), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, sizeof(CurveVertex), (void*)offsetof(CurveVertex, curve));
+        glEnableVertexAttribArray(3);
+
+        glBindBuffer(GL_TEXTURE_BUFFER, buffers.curveBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, buffers.curveTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, buffers.curveBuffer);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        // integer texels, so the curve index and position bits come back exactly
+        buffers.lineTexture = CreateBufferTexture(buffers.vertexBuffer, GL_RGBA32UI);
+    }
+
+    const std::vector<CurveBatch::Curve>& curves = batch.GetCurves();
+    if (buffers.pointsVersion != batch.GetPointsVersion())
+    {
+        const std::vector<glm::vec3>& points = batch.GetPoints();
+        std::vector<CurveVertex> vertices(points.size());
+        buffers.firsts.clear();
+        buffers.counts.clear();
+        for (uint32_t c = 0; c < curves.size(); c++)
+        {
+            for (uint32_t i = curves[c].first; i < curves[c].first + curves[c].count; i++)
+            {
+                vertices[i].position = points[i];
+                vertices[i].curve = c;
+            }
+            buffers.firsts.push_back(static_cast<int>(curves[c].first));
+            buffers.counts.push_back(static_cast<int>(curves[c].count));
+        }
+        state.BindBuffer(GL_ARRAY_BUFFER, buffers.vertexBuffer);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(CurveVertex), vertices.data(), GL_STATIC_DRAW);
+        buffers.pointsVersion = batch.GetPointsVersion();
+    }
+
+    if (buffers.curvesVersion != batch.GetCurvesVersion())
+    {
+        // matches curveData in Scene.vert: four transform columns, then the colour
+        std::vector<glm::vec4> texels(curves.size() * 5);
+        for (size_t c = 0; c < curves.size(); c++)
+        {
+            for (int column = 0; column < 4; column++)
+                texels[c * 5 + column] = curves[c].transform[column];
+            texels[c * 5 + 4] = curves[c].color;
+        }
+        glBindBuffer(GL_TEXTURE_BUFFER, buffers.curveBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, texels.size() * sizeof(glm::vec4), texels.data(), GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        buffers.curvesVersion = batch.GetCurvesVersion();
+    }
+}
+
+void GlBackend::EndFrame()
+{
+    stream.EndFrame();
+}
+
+/// \brief One instance of 6 vertices per segment of the strip first..last
+void GlBackend::DrawWideLines(Shader* program, unsigned texture, int first, int last)
+{
+    if (last <= first)
+        return;
+    Use(program);
+    glActiveTexture(GL_TEXTURE0 + LineVerticesUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    program->SetInt(LineVerticesUniform, LineVerticesUnit);
+    program->SetInt(LineFirstUniform, first);
+    program->SetInt(LineLastUniform, last);
+    program->SetFloat(LineWidthUniform, lineWidth);
+    program->SetInt(LineJoinUniform, lineJoin == LineJoin::Round ? 1 : 0);
+    program->SetVec2(ViewportSizeUniform, viewportSize);
+    state.BindVertexArray(emptyVertexArray);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, last - first);
+}
+
+/// \brief Points through Splat.vert/Splat.frag, with the mesh's vertex array bound. Blended
+/// splats are drawn twice into the SplatBuffer: depth of the nearest splats pushed back by
+/// half a splat, then the weighted sum of every splat in front of that; the resolve pass
+/// divides by the weight and writes the result into the frame at the nearest splat's depth,
+/// with the half-splat offset taken off again.
+void GlBackend::DrawSplats(const Mesh& mesh, size_t first, size_t count)
+{
+    Shader* program = programs.splats;
+    program->SetFloat(SplatSizeUniform, pointSize);
+    program->SetFloat(ViewportHeightUniform, viewportSize.y);
+    program->SetFloat(MaxPointSizeUniform, maxPointSize);
+    state.SetEnabled(GL_PROGRAM_POINT_SIZE, true);
+    auto drawPoints = [&](int pass)
+    {
+        program->SetInt(SplatPassUniform, pass);
+        if (mesh.indexCount > 0)
+            glDrawElements(GL_POINTS, (GLsizei)count, GL_UNSIGNED_INT, (void*)(first * sizeof(uint32_t)));
+        else
+            glDrawArrays(GL_POINTS, (GLint)first, (GLsizei)count);
+    };
+
+    if (pointMode != PointMode::BlendedSplat || programs.splatResolve == nullptr ||
+        !splatBuffer.Resize(viewport[2], viewport[3]))
+    {
+        drawPoints(SplatOpaquePass);
+        state.SetEnabled(GL_PROGRAM_POINT_SIZE, false);
+        return;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, splatBuffer.GetFramebuffer());
+    glViewport(0, 0, viewport[2], viewport[3]);
+    state.ClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    program->SetFloat(SplatDepthOffsetUniform, pointSize * 0.5f);
+    drawPoints(SplatVisibilityPass);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+    glDepthMask(GL_FALSE);
+    glDepthFunc(GL_LEQUAL);
+    state.SetEnabled(GL_BLEND, true);
+    glBlendFunc(GL_ONE, GL_ONE);
+    drawPoints(SplatAccumulationPass);
+    state.SetEnabled(GL_BLEND, false);
+    glDepthFunc(GL_LESS);
+    glDepthMask(GL_TRUE);
+    state.SetEnabled(GL_PROGRAM_POINT_SIZE, false);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, frameTarget);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    Use(programs.splatResolve);
+    glActiveTexture(GL_TEXTURE0 + SplatColorUnit);
+    glBindTexture(GL_TEXTURE_2D, splatBuffer.GetColorTexture());
+    glActiveTexture(GL_TEXTURE0 + SplatDepthUnit);
+    glBindTexture(GL_TEXTURE_2D, splatBuffer.GetDepthTexture());
+    programs.splatResolve->SetInt(SplatColorUniform, SplatColorUnit);
+    programs.splatResolve->SetInt(SplatDepthUniform, SplatDepthUnit);
+    programs.splatResolve->SetFloat(SplatDepthOffsetUniform, pointSize * 0.5f);
+    state.BindVertexArray(emptyVertexArray);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+unsigned GlBackend::CreateBufferTexture(unsigned buffer, unsigned format)
+{
+    unsigned texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    return texture;
+}
+
+/// \brief Makes program current and gives it the model matrix if it does not have it yet
+void GlBackend::Use(Shader* program)
+{
+    state.UseProgram(program->GetProgram());
+    if (modelProgram != program->GetProgram())
+    {
+        program->SetMat4(ModelUniform, model);
+        modelProgram = program->GetProgram();
+    }
+}
+
+void GlBackend::ReadPixels(int& width, int& height, std::vector<uint8_t>& rgba)
+{
+    // whatever is being drawn to: the window's back buffer or the headless FBO
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    width = viewport[2];
+    height = viewport[3];
+    const size_t rowBytes = static_cast<size_t>(width) * 4;
+    rgba.resize(rowBytes * height);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(viewport[0], viewport[1], width, height, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+
+    // GL rows start at the bottom
+    for (int y = 0; y < height / 2; y++)
+        std::swap_ranges(rgba.begin() + y * rowBytes, rgba.begin() + (y + 1) * rowBytes, rgba.begin() + (height - 1 - y) * rowBytes);
+}
@@ -0,0 +1,118 @@
+﻿#pragma once
+#include <map>
+#include <vector>
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+
+#include "CameraUniformBuffer.h"
+#include "RenderBackend.h"
+#include "SplatBuffer.h"
+#include "StreamBuffer.h"
+
+class GlState;
+class Shader;
+
+/// \brief RenderBackend on the current GL context. Meshes are vertex arrays, state changes
+/// go through GlState and camera matrices through the shared CameraUniformBuffer.
+/// Dynamic meshes have no buffer of their own: UpdateMesh streams their vertices into a
+/// shared StreamBuffer, so they are drawn only in the frame they were last updated in.
+/// Line strips wider than a pixel are expanded into quads by WideLine.vert, since core
+/// profile drivers may ignore or clamp glLineWidth. Splats are GL points sized in
+/// Splat.vert; blended splats take a visibility and an accumulation pass into a SplatBuffer
+/// and are resolved onto the frame.
+/// Create and destroy it while the context is current.
+class GlBackend : public RenderBackend
+{
+public:
+    /// \brief Programs the backend draws with. Each has model and CameraBlock and may be
+    /// swapped in place by hot reload.
+    struct Programs
+    {
+        Shader* scene = nullptr;      // Scene VERTEX_COLOR, for meshes
+        Shader* curves = nullptr;     // Scene CURVE_BATCH, for DrawCurves; null skips curve batches
+        Shader* lines = nullptr;      // WideLine VERTEX_COLOR; null draws every line 1 pixel wide
+        Shader* curveLines = nullptr; // WideLine CURVE_BATCH
+        Shader* splats = nullptr;     // Splat; null draws every point mode as squares
+        Shader* splatResolve = nullptr; // SplatResolve; null draws blended splats opaque
+    };
+
+    GlBackend(const Programs& programs, GlState& state);
+    ~GlBackend() override;
+
+    const char* GetName() const override { return "OpenGL"; }
+
+    MeshHandle CreateMesh(const float* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount, bool dynamic) override;
+    void UpdateMesh(MeshHandle mesh, const float* vertices, size_t vertexCount) override;
+    void DestroyMesh(MeshHandle mesh) override;
+
+    void BeginFrame(const Camera& camera, const glm::vec4& clearColor) override;
+    void SetModel(const glm::mat4& model) override;
+    void SetLineWidth(float width) override;
+    void SetLineJoin(LineJoin join) override { lineJoin = join; }
+    void SetPointSize(float size) override;
+    void SetPointMode(PointMode mode) override { pointMode = mode; }
+    void Draw(MeshHandle mesh, PrimitiveType type, size_t first = 0, size_t count = 0) override;
+    void DrawCurves(const CurveBatch& batch) override;
+    void EndFrame() override;
+
+    void ReadPixels(int& width, int& height, std::vector<uint8_t>& rgba) override;
+
+private:
+    struct Mesh
+    {
+        unsigned vertexArray = 0;
+        unsigned vertexBuffer = 0;
+        unsigned indexBuffer = 0;
+        size_t vertexCount = 0;
+        size_t indexCount = 0;
+        bool dynamic = false;
+        size_t streamOffset = 0;  // bytes into the stream buffer, dynamic meshes only
+        size_t streamCount = 0;   // vertices written there
+        uint64_t streamFrame = 0; // StreamBuffer::GetFrame() when they were written
+        unsigned lineTexture = 0; // the vertex buffer as a buffer texture, made on the first wide line draw
+    };
+
+    /// \brief GPU copy of a CurveBatch: the points with their curve index, drawn with one
+    /// glMultiDrawArrays, and the per-curve data as a buffer texture
+    struct CurveBuffers
+    {
+        unsigned vertexArray = 0;
+        unsigned vertexBuffer = 0;
+        unsigned curveBuffer = 0;
+        unsigned curveTexture = 0;
+        unsigned lineTexture = 0; // vertexBuffer as a buffer texture, for wide lines
+        uint64_t pointsVersion = 0;
+        uint64_t curvesVersion = 0;
+        std::vector<int> firsts;
+        std::vector<int> counts;
+    };
+
+    Programs programs;
+    GlState& state;
+    glm::mat4 model;
+    unsigned modelProgram = 0; // the program whose model uniform holds model
+    float lineWidth = 1.0f;
+    LineJoin lineJoin = LineJoin::Miter;
+    float pointSize = 1.0f;
+    PointMode pointMode = PointMode::Square;
+    int viewport[4] = {};
+    int frameTarget = 0; // framebuffer the frame is drawn into
+    glm::vec2 viewportSize;
+    int maxTextureBufferSize = 0;
+    float maxPointSize = 1.0f;
+    unsigned emptyVertexArray = 0;  // for draws that fetch everything themselves, a vertex array must still be bound
+    SplatBuffer splatBuffer;
+    unsigned streamTexture = 0;     // the stream buffer as a buffer texture
+    unsigned streamTextureBuffer = 0; // which buffer streamTexture was made for
+    CameraUniformBuffer cameraUniforms;
+    StreamBuffer stream;
+    size_t streamBytes = 0; // what every dynamic mesh together needs per frame
+    std::vector<Mesh> meshes; // handle - 1
+    std::map<uint32_t, CurveBuffers> curveBatches; // by CurveBatch::GetId(), kept until the backend goes
+
+    void Use(Shader* program);
+    void DrawWideLines(Shader* program, unsigned texture, int first, int last);
+    void DrawSplats(const Mesh& mesh, size_t first, size_t count);
+    static unsigned CreateBufferTexture(unsigned buffer, unsigned format);
+    void UploadCurves(const CurveBatch& batch, CurveBuffers& buffers);
+};
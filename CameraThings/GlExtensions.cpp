@@ -0,0 +1,76 @@
+﻿#include "GlExtensions.h"
+
+#include <string>
+#include <vector>
+
+namespace
+{
+    int majorVersion = 0;
+    int minorVersion = 0;
+    std::vector<std::string> extensions;
+}
+
+bool GlExtensions::hasProgramBinary = false;
+PFNGLGETPROGRAMBINARYPROC_EXT GlExtensions::GetProgramBinary = nullptr;
+PFNGLPROGRAMBINARYPROC_EXT GlExtensions::ProgramBinary = nullptr;
+PFNGLPROGRAMPARAMETERIPROC_EXT GlExtensions::ProgramParameteri = nullptr;
+bool GlExtensions::hasParallelShaderCompile = false;
+PFNGLMAXSHADERCOMPILERTHREADSPROC_EXT GlExtensions::MaxShaderCompilerThreads = nullptr;
+bool GlExtensions::hasBufferStorage = false;
+PFNGLBUFFERSTORAGEPROC_EXT GlExtensions::BufferStorage = nullptr;
+
+void GlExtensions::Load(GLADloadproc load)
+{
+    glGetIntegerv(GL_MAJOR_VERSION, &majorVersion);
+    glGetIntegerv(GL_MINOR_VERSION, &minorVersion);
+
+    int count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    extensions.clear();
+    for (int i = 0; i < count; i++)
+        extensions.push_back(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i)));
+
+    if (IsVersionAtLeast(4, 1) || IsSupported("GL_ARB_get_program_binary"))
+    {
+        GetProgramBinary = (PFNGLGETPROGRAMBINARYPROC_EXT)load("glGetProgramBinary");
+        ProgramBinary = (PFNGLPROGRAMBINARYPROC_EXT)load("glProgramBinary");
+        ProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC_EXT)load("glProgramParameteri");
+        hasProgramBinary = GetProgramBinary && ProgramBinary && ProgramParameteri;
+    }
+
+    // drivers may expose the extension yet support no binary formats at all
+    if (hasProgramBinary)
+    {
+        int formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        hasProgramBinary = formats > 0;
+    }
+
+    if (IsSupported("GL_KHR_parallel_shader_compile"))
+        MaxShaderCompilerThreads = (PFNGLMAXSHADERCOMPILERTHREADSPROC_EXT)load("glMaxShaderCompilerThreadsKHR");
+    else if (IsSupported("GL_ARB_parallel_shader_compile"))
+        MaxShaderCompilerThreads = (PFNGLMAXSHADERCOMPILERTHREADSPROC_EXT)load("glMaxShaderCompilerThreadsARB");
+    hasParallelShaderCompile = MaxShaderCompilerThreads != nullptr;
+    // let the driver pick how many threads to use
+    if (hasParallelShaderCompile)
+        MaxShaderCompilerThreads(0xFFFFFFFFu);
+
+    if (IsVersionAtLeast(4, 4) || IsSupported("GL_ARB_buffer_storage"))
+        BufferStorage = (PFNGLBUFFERSTORAGEPROC_EXT)load("glBufferStorage");
+    hasBufferStorage = BufferStorage != nullptr;
+}
+
+bool GlExtensions::IsSupported(const char* extension)
+{
+    for (const std::string& name : extensions)
+    {
+        if (name == extension)
+            return true;
+    }
+    return false;
+}
+
+bool GlExtensions::IsVersionAtLeast(int major, int minor)
+{
+    return majorVersion > major || (majorVersion == major && minorVersion >= minor);
+}
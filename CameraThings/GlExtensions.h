@@ -0,0 +1,54 @@
+﻿#pragma once
+#include <glad/glad.h>
+
+// Entry points and enums beyond the GL 3.3 core that glad was generated for. They are
+// loaded by hand after the context is current and are only used when supported.
+
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#define GL_CLIENT_STORAGE_BIT 0x0200
+#endif
+
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYPROC_EXT)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP PFNGLPROGRAMBINARYPROC_EXT)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIPROC_EXT)(GLuint program, GLenum pname, GLint value);
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSPROC_EXT)(GLuint count);
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC_EXT)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+namespace GlExtensions
+{
+    /// \brief Reads the context version and extension list and loads what is available
+    /// \param load the same loader glad was given (e.g. glfwGetProcAddress)
+    void Load(GLADloadproc load);
+
+    bool IsSupported(const char* extension);
+    bool IsVersionAtLeast(int major, int minor);
+
+    // GL 4.1 / ARB_get_program_binary
+    extern bool hasProgramBinary;
+    extern PFNGLGETPROGRAMBINARYPROC_EXT GetProgramBinary;
+    extern PFNGLPROGRAMBINARYPROC_EXT ProgramBinary;
+    extern PFNGLPROGRAMPARAMETERIPROC_EXT ProgramParameteri;
+
+    // KHR/ARB_parallel_shader_compile: compiles run on driver threads and
+    // GL_COMPLETION_STATUS_KHR can be polled without waiting for them
+    extern bool hasParallelShaderCompile;
+    extern PFNGLMAXSHADERCOMPILERTHREADSPROC_EXT MaxShaderCompilerThreads;
+
+    // GL 4.4 / ARB_buffer_storage: immutable storage that can stay mapped while drawn from
+    extern bool hasBufferStorage;
+    extern PFNGLBUFFERSTORAGEPROC_EXT BufferStorage;
+}
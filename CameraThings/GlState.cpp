@@ -0,0 +1,117 @@
+﻿#include "GlState.h"
+
+namespace
+{
+    const unsigned Unknown = 0xFFFFFFFFu;
+}
+
+const GLenum GlState::Capabilities[CapabilityCount] = {
+    GL_DEPTH_TEST, GL_BLEND, GL_CULL_FACE, GL_PROGRAM_POINT_SIZE, GL_PRIMITIVE_RESTART, GL_SCISSOR_TEST
+};
+
+void GlState::Invalidate()
+{
+    program = Unknown;
+    vertexArray = Unknown;
+    arrayBuffer = Unknown;
+    elementBuffer = Unknown;
+    lineWidth = -1.0f;
+    pointSize = -1.0f;
+    for (float& c : clearColor)
+        c = -1.0f;
+    for (int8_t& e : enabled)
+        e = -1;
+}
+
+void GlState::BeginFrame()
+{
+    if (frame.issued + frame.skipped > 0)
+    {
+        lastFrame = frame;
+        total.issued += frame.issued;
+        total.skipped += frame.skipped;
+        frameCount++;
+    }
+    frame = Counters();
+}
+
+void GlState::UseProgram(unsigned program)
+{
+    if (Changed(this->program != program))
+    {
+        glUseProgram(program);
+        this->program = program;
+    }
+}
+
+void GlState::BindVertexArray(unsigned vao)
+{
+    if (Changed(vertexArray != vao))
+    {
+        glBindVertexArray(vao);
+        vertexArray = vao;
+        // the element buffer binding belongs to the vertex array
+        elementBuffer = Unknown;
+    }
+}
+
+void GlState::BindBuffer(GLenum target, unsigned buffer)
+{
+    unsigned* shadow = target == GL_ARRAY_BUFFER ? &arrayBuffer
+                     : target == GL_ELEMENT_ARRAY_BUFFER ? &elementBuffer
+                     : nullptr;
+    if (Changed(shadow == nullptr || *shadow != buffer))
+    {
+        glBindBuffer(target, buffer);
+        if (shadow)
+            *shadow = buffer;
+    }
+}
+
+void GlState::LineWidth(float width)
+{
+    if (Changed(lineWidth != width))
+    {
+        glLineWidth(width);
+        lineWidth = width;
+    }
+}
+
+void GlState::PointSize(float size)
+{
+    if (Changed(pointSize != size))
+    {
+        glPointSize(size);
+        pointSize = size;
+    }
+}
+
+void GlState::ClearColor(float r, float g, float b, float a)
+{
+    if (Changed(clearColor[0] != r || clearColor[1] != g || clearColor[2] != b || clearColor[3] != a))
+    {
+        glClearColor(r, g, b, a);
+        clearColor[0] = r;
+        clearColor[1] = g;
+        clearColor[2] = b;
+        clearColor[3] = a;
+    }
+}
+
+void GlState::SetEnabled(GLenum capability, bool enable)
+{
+    int index = 0;
+    while (index < CapabilityCount && Capabilities[index] != capability)
+        index++;
+
+    const int8_t value = enable ? 1 : 0;
+    if (Changed(index == CapabilityCount || enabled[index] != value))
+    {
+        if (enable)
+            glEnable(capability);
+        else
+            glDisable(capability);
+        if (index < CapabilityCount)
+            enabled[index] = value;
+    }
+}
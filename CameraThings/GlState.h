@@ -0,0 +1,65 @@
+﻿#pragma once
+#include <cstdint>
+#include <glad/glad.h>
+
+/// \brief Shadow copy of the GL state the renderer touches. Each setter only calls GL when
+/// the value actually changes and counts issued and skipped calls, so redundant binds show
+/// up in the per-frame numbers. Code that changes the same state behind its back must call
+/// Invalidate() afterwards.
+class GlState
+{
+public:
+    struct Counters
+    {
+        uint32_t issued = 0;
+        uint32_t skipped = 0;
+    };
+
+    GlState() { Invalidate(); }
+
+    /// \brief Forgets everything, so the next call of every setter reaches GL
+    void Invalidate();
+
+    /// \brief Starts a new frame's counters; the finished frame stays readable in GetLastFrame
+    void BeginFrame();
+    const Counters& GetLastFrame() const { return lastFrame; }
+    const Counters& GetTotal() const { return total; }
+    uint64_t GetFrameCount() const { return frameCount; }
+
+    void UseProgram(unsigned program);
+    void BindVertexArray(unsigned vao);
+    /// \brief GL_ARRAY_BUFFER and GL_ELEMENT_ARRAY_BUFFER are shadowed, other targets pass through
+    void BindBuffer(GLenum target, unsigned buffer);
+    void LineWidth(float width);
+    void PointSize(float size);
+    void ClearColor(float r, float g, float b, float a);
+    void SetEnabled(GLenum capability, bool enabled);
+
+private:
+    static const int CapabilityCount = 6;
+    static const GLenum Capabilities[CapabilityCount];
+
+    unsigned program;
+    unsigned vertexArray;
+    unsigned arrayBuffer;
+    unsigned elementBuffer;
+    float lineWidth;
+    float pointSize;
+    float clearColor[4];
+    int8_t enabled[CapabilityCount]; // -1 unknown
+
+    Counters frame;
+    Counters lastFrame;
+    Counters total;
+    uint64_t frameCount = 0;
+
+    /// \brief Counts the call and tells whether it has to be issued
+    bool Changed(bool changed)
+    {
+        if (changed)
+            frame.issued++;
+        else
+            frame.skipped++;
+        return changed;
+    }
+};
@@ -0,0 +1,94 @@
+﻿#include "InputQueue.h"
+
+void InputQueue::PushCursor(double x, double y)
+{
+    InputEvent event;
+    event.type = InputEventType::CursorMove;
+    event.key = 0;
+    event.x = x;
+    event.y = y;
+    queued.push_back(event);
+}
+
+void InputQueue::PushKey(int key, bool pressed)
+{
+    InputEvent event;
+    event.type = pressed ? InputEventType::KeyDown : InputEventType::KeyUp;
+    event.key = key;
+    event.x = 0.0;
+    event.y = 0.0;
+    queued.push_back(event);
+}
+
+void InputQueue::PushScroll(double x, double y)
+{
+    InputEvent event;
+    event.type = InputEventType::Scroll;
+    event.key = 0;
+    event.x = x;
+    event.y = y;
+    queued.push_back(event);
+}
+
+void InputQueue::Push(const InputEvent& event)
+{
+    queued.push_back(event);
+}
+
+InputFrame InputQueue::Consume()
+{
+    InputFrame frame;
+    // cursor events carry absolute positions, so the net movement is just last minus first
+    double startX = lastX, startY = lastY;
+    keysPressed.reset();
+    for (const InputEvent& event : queued)
+    {
+        switch (event.type)
+        {
+        case InputEventType::CursorMove:
+            if (!hasCursor)
+            {
+                // first position ever seen: nothing to measure a delta against
+                startX = event.x;
+                startY = event.y;
+                hasCursor = true;
+            }
+            lastX = event.x;
+            lastY = event.y;
+            frame.mouseMoved = true;
+            break;
+        case InputEventType::KeyDown:
+        case InputEventType::KeyUp:
+            if (event.key >= 0 && event.key < KeyCount)
+            {
+                keysDown[event.key] = event.type == InputEventType::KeyDown;
+                if (event.type == InputEventType::KeyDown)
+                    keysPressed[event.key] = true;
+            }
+            break;
+        case InputEventType::Scroll:
+            frame.scroll += static_cast<float>(event.y);
+            break;
+        }
+    }
+
+    if (frame.mouseMoved)
+    {
+        frame.mouseDeltaX = static_cast<float>(lastX - startX);
+        frame.mouseDeltaY = static_cast<float>(startY - lastY); // window y grows downwards
+    }
+
+    consumed.swap(queued);
+    queued.clear();
+    return frame;
+}
+
+bool InputQueue::IsKeyDown(int key) const
+{
+    return key >= 0 && key < KeyCount && keysDown[key];
+}
+
+bool InputQueue::WasKeyPressed(int key) const
+{
+    return key >= 0 && key < KeyCount && keysPressed[key];
+}
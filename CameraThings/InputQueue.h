@@ -0,0 +1,62 @@
+﻿#pragma once
+#include <bitset>
+#include <cstdint>
+#include <vector>
+
+enum class InputEventType : uint8_t
+{
+    CursorMove,
+    KeyDown,
+    KeyUp,
+    Scroll
+};
+
+/// \brief One raw event as the window system delivered it
+struct InputEvent
+{
+    InputEventType type;
+    int key;      // key events
+    double x, y;  // cursor events: window coordinates, scroll events: offsets
+};
+
+/// \brief Everything that happened since the last frame, merged
+struct InputFrame
+{
+    float mouseDeltaX = 0.0f; // right is positive
+    float mouseDeltaY = 0.0f; // up is positive
+    bool mouseMoved = false;
+    float scroll = 0.0f;      // wheel notches, away from the user is positive
+};
+
+/// \brief Collects input from the GLFW callbacks without acting on it. Once per frame
+/// Consume() folds the queued events into a single InputFrame and the held key set, so the
+/// camera is updated once however many events the OS sent. The consumed events are kept
+/// for the frame so they can be logged and fed back through Push() later.
+class InputQueue
+{
+public:
+    static const int KeyCount = 512;
+
+    void PushCursor(double x, double y);
+    void PushKey(int key, bool pressed);
+    void PushScroll(double x, double y);
+    void Push(const InputEvent& event);
+
+    /// \brief Applies all queued events and returns the merged cursor movement
+    InputFrame Consume();
+
+    bool IsKeyDown(int key) const;
+    /// \brief True if the key went down during the last consumed frame
+    bool WasKeyPressed(int key) const;
+
+    /// \brief The events that went into the last Consume(), in arrival order
+    const std::vector<InputEvent>& GetConsumedEvents() const { return consumed; }
+
+private:
+    std::vector<InputEvent> queued;
+    std::vector<InputEvent> consumed;
+    std::bitset<KeyCount> keysDown;
+    std::bitset<KeyCount> keysPressed;
+    bool hasCursor = false;
+    double lastX = 0.0, lastY = 0.0;
+};
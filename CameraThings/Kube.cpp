@@ -1 +1,18 @@
 ﻿#include "Kube.h"
+
+/// \brief World space box around the cube, used by the static collision hierarchy
+Aabb Kube::GetBounds() const
+{
+    Aabb box;
+    box.min = position - glm::vec3(a);
+    box.max = position + glm::vec3(a);
+    return box;
+}
+
+Sphere Kube::GetBoundingSphere() const
+{
+    Sphere sphere;
+    sphere.center = position;
+    sphere.radius = radius;
+    return sphere;
+}
@@ -1,7 +1,11 @@
 ﻿#pragma once
+#include <cmath>
 #include <string>
 #include <vector>
 #include <glm/fwd.hpp>
+#include <glm/vec3.hpp>
+
+#include "Collision.h"
 
 struct vertex {
     float x, y, z, r, g, b;
@@ -24,16 +28,20 @@ public:
         mVertices.push_back(v3);
         mVertices.push_back(v1);
         mVertices.push_back(v2);
+        radius = a * std::sqrt(3.0f);
     }
     std::vector<vertex> mVertices;
     // glm::mat4<float> matrix;
-    // glm::vec3<float> position;
+    glm::vec3 position = glm::vec3(0.0f);
     // std::string Name;
 
+    Aabb GetBounds() const;
+    Sphere GetBoundingSphere() const;
+
 private:
     float a{1.0f};
 
-    float radius = a * sqrt(3);
+    float radius = a * std::sqrt(3.0f);
 
     // void test(obj mia)
     // {
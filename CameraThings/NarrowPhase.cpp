@@ -0,0 +1,191 @@
+﻿#include "NarrowPhase.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+void SphereSoA::Clear()
+{
+    x.clear();
+    y.clear();
+    z.clear();
+    radius.clear();
+}
+
+void SphereSoA::Add(const Sphere& sphere)
+{
+    x.push_back(sphere.center.x);
+    y.push_back(sphere.center.y);
+    z.push_back(sphere.center.z);
+    radius.push_back(sphere.radius);
+}
+
+void AabbSoA::Clear()
+{
+    minX.clear();
+    minY.clear();
+    minZ.clear();
+    maxX.clear();
+    maxY.clear();
+    maxZ.clear();
+}
+
+void AabbSoA::Add(const Aabb& box)
+{
+    minX.push_back(box.min.x);
+    minY.push_back(box.min.y);
+    minZ.push_back(box.min.z);
+    maxX.push_back(box.max.x);
+    maxY.push_back(box.max.y);
+    maxZ.push_back(box.max.z);
+}
+
+namespace
+{
+    inline bool SphereHitsSphere(float qx, float qy, float qz, float qr, const SphereSoA& s, size_t i)
+    {
+        float dx = s.x[i] - qx;
+        float dy = s.y[i] - qy;
+        float dz = s.z[i] - qz;
+        float r = s.radius[i] + qr;
+        return dx * dx + dy * dy + dz * dz <= r * r;
+    }
+
+    inline float AxisGap(float c, float lo, float hi)
+    {
+        float below = lo - c;
+        float above = c - hi;
+        float gap = below > above ? below : above;
+        return gap > 0.0f ? gap : 0.0f;
+    }
+
+    inline bool SphereHitsAabb(float qx, float qy, float qz, float r2, const AabbSoA& b, size_t i)
+    {
+        float dx = AxisGap(qx, b.minX[i], b.maxX[i]);
+        float dy = AxisGap(qy, b.minY[i], b.maxY[i]);
+        float dz = AxisGap(qz, b.minZ[i], b.maxZ[i]);
+        return dx * dx + dy * dy + dz * dz <= r2;
+    }
+
+    inline void SetBit(std::vector<uint32_t>& hitMask, size_t i)
+    {
+        hitMask[i / 32] |= 1u << (i % 32);
+    }
+
+#if defined(__AVX2__)
+    inline __m256 AxisGap8(__m256 c, __m256 lo, __m256 hi)
+    {
+        __m256 gap = _mm256_max_ps(_mm256_sub_ps(lo, c), _mm256_sub_ps(c, hi));
+        return _mm256_max_ps(gap, _mm256_setzero_ps());
+    }
+
+    inline __m256 LengthSquared8(__m256 dx, __m256 dy, __m256 dz)
+    {
+        // plain mul/add rather than fma so the result matches the scalar path bit for bit
+        return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+    }
+#endif
+}
+
+void NarrowPhase::SphereVsSpheres(const Sphere& query, const SphereSoA& spheres, std::vector<uint32_t>& hitMask)
+{
+    const size_t count = spheres.Size();
+    hitMask.assign((count + 31) / 32, 0u);
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    const __m256 qx = _mm256_set1_ps(query.center.x);
+    const __m256 qy = _mm256_set1_ps(query.center.y);
+    const __m256 qz = _mm256_set1_ps(query.center.z);
+    const __m256 qr = _mm256_set1_ps(query.radius);
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(&spheres.x[i]), qx);
+        __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(&spheres.y[i]), qy);
+        __m256 dz = _mm256_sub_ps(_mm256_loadu_ps(&spheres.z[i]), qz);
+        __m256 r = _mm256_add_ps(_mm256_loadu_ps(&spheres.radius[i]), qr);
+        __m256 hit = _mm256_cmp_ps(LengthSquared8(dx, dy, dz), _mm256_mul_ps(r, r), _CMP_LE_OQ);
+        hitMask[i / 32] |= static_cast<uint32_t>(_mm256_movemask_ps(hit)) << (i % 32);
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        if (SphereHitsSphere(query.center.x, query.center.y, query.center.z, query.radius, spheres, i))
+            SetBit(hitMask, i);
+    }
+}
+
+void NarrowPhase::SphereVsAabbs(const Sphere& query, const AabbSoA& boxes, std::vector<uint32_t>& hitMask)
+{
+    const size_t count = boxes.Size();
+    const float r2 = query.radius * query.radius;
+    hitMask.assign((count + 31) / 32, 0u);
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    const __m256 qx = _mm256_set1_ps(query.center.x);
+    const __m256 qy = _mm256_set1_ps(query.center.y);
+    const __m256 qz = _mm256_set1_ps(query.center.z);
+    const __m256 radiusSquared = _mm256_set1_ps(r2);
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 dx = AxisGap8(qx, _mm256_loadu_ps(&boxes.minX[i]), _mm256_loadu_ps(&boxes.maxX[i]));
+        __m256 dy = AxisGap8(qy, _mm256_loadu_ps(&boxes.minY[i]), _mm256_loadu_ps(&boxes.maxY[i]));
+        __m256 dz = AxisGap8(qz, _mm256_loadu_ps(&boxes.minZ[i]), _mm256_loadu_ps(&boxes.maxZ[i]));
+        __m256 hit = _mm256_cmp_ps(LengthSquared8(dx, dy, dz), radiusSquared, _CMP_LE_OQ);
+        hitMask[i / 32] |= static_cast<uint32_t>(_mm256_movemask_ps(hit)) << (i % 32);
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        if (SphereHitsAabb(query.center.x, query.center.y, query.center.z, r2, boxes, i))
+            SetBit(hitMask, i);
+    }
+}
+
+void NarrowPhase::FilterSpherePairs(const SphereSoA& spheres, const std::vector<CollisionPair>& candidates, std::vector<CollisionPair>& hits)
+{
+    FilterSpherePairs(spheres, candidates.data(), candidates.size(), hits);
+}
+
+void NarrowPhase::FilterSpherePairs(const SphereSoA& spheres, const CollisionPair* candidates, size_t count, std::vector<CollisionPair>& hits)
+{
+    hits.clear();
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    static_assert(sizeof(CollisionPair) == 2 * sizeof(int), "pairs are loaded as packed int pairs");
+    const __m256i evenOdd = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    for (; i + 8 <= count; i += 8)
+    {
+        // eight interleaved (a, b) pairs -> one register of a indices and one of b indices
+        const __m256i* packed = reinterpret_cast<const __m256i*>(&candidates[i]);
+        __m256i lo = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(packed), evenOdd);
+        __m256i hi = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(packed + 1), evenOdd);
+        __m256i a = _mm256_permute2x128_si256(lo, hi, 0x20);
+        __m256i b = _mm256_permute2x128_si256(lo, hi, 0x31);
+
+        __m256 dx = _mm256_sub_ps(_mm256_i32gather_ps(spheres.x.data(), a, 4), _mm256_i32gather_ps(spheres.x.data(), b, 4));
+        __m256 dy = _mm256_sub_ps(_mm256_i32gather_ps(spheres.y.data(), a, 4), _mm256_i32gather_ps(spheres.y.data(), b, 4));
+        __m256 dz = _mm256_sub_ps(_mm256_i32gather_ps(spheres.z.data(), a, 4), _mm256_i32gather_ps(spheres.z.data(), b, 4));
+        __m256 r = _mm256_add_ps(_mm256_i32gather_ps(spheres.radius.data(), a, 4), _mm256_i32gather_ps(spheres.radius.data(), b, 4));
+        __m256 hit = _mm256_cmp_ps(LengthSquared8(dx, dy, dz), _mm256_mul_ps(r, r), _CMP_LE_OQ);
+
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_ps(hit));
+        for (uint32_t lane = 0; mask != 0; lane++, mask >>= 1)
+        {
+            if (mask & 1u)
+                hits.push_back(candidates[i + lane]);
+        }
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        const CollisionPair& pair = candidates[i];
+        if (SphereHitsSphere(spheres.x[pair.a], spheres.y[pair.a], spheres.z[pair.a], spheres.radius[pair.a], spheres, pair.b))
+            hits.push_back(pair);
+    }
+}
@@ -0,0 +1,58 @@
+﻿#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Collision.h"
+
+/// \brief Spheres stored as one array per component so eight can be loaded at once
+struct SphereSoA
+{
+    std::vector<float> x, y, z, radius;
+
+    void Clear();
+    void Add(const Sphere& sphere);
+    size_t Size() const { return x.size(); }
+};
+
+struct AabbSoA
+{
+    std::vector<float> minX, minY, minZ;
+    std::vector<float> maxX, maxY, maxZ;
+
+    void Clear();
+    void Add(const Aabb& box);
+    size_t Size() const { return minX.size(); }
+};
+
+/// \brief Batched exact tests run on the candidates a broad phase (Bvh, grid, ...) hands out.
+/// Distances are compared squared, so no sqrt is taken. Uses AVX2 when the compiler
+/// targets it (/arch:AVX2, -mavx2) and a scalar loop otherwise; both give the same results.
+///
+/// Hit masks hold one bit per tested element, 32 elements per word, bit i % 32 of word i / 32.
+namespace NarrowPhase
+{
+    void SphereVsSpheres(const Sphere& query, const SphereSoA& spheres, std::vector<uint32_t>& hitMask);
+    void SphereVsAabbs(const Sphere& query, const AabbSoA& boxes, std::vector<uint32_t>& hitMask);
+
+    /// \brief Keeps the candidate pairs whose spheres really overlap
+    /// \param spheres all objects, indexed by the pair members
+    /// \param candidates pairs from the broad phase
+    /// \param hits receives the overlapping pairs (cleared first)
+    void FilterSpherePairs(const SphereSoA& spheres, const std::vector<CollisionPair>& candidates, std::vector<CollisionPair>& hits);
+    void FilterSpherePairs(const SphereSoA& spheres, const CollisionPair* candidates, size_t count, std::vector<CollisionPair>& hits);
+
+    /// \brief Calls function(index) for every set bit of a hit mask
+    template <typename Function>
+    void ForEachHit(const std::vector<uint32_t>& hitMask, Function function)
+    {
+        for (size_t word = 0; word < hitMask.size(); word++)
+        {
+            uint32_t bits = hitMask[word];
+            for (uint32_t bit = 0; bits != 0; bit++, bits >>= 1)
+            {
+                if (bits & 1u)
+                    function(static_cast<uint32_t>(word * 32 + bit));
+            }
+        }
+    }
+}
@@ -0,0 +1,24 @@
+﻿#pragma once
+
+/// \brief Framebuffer object with colour and depth renderbuffers, so a headless context
+/// (no visible window, no default framebuffer worth reading) has something to draw into
+class OffscreenTarget
+{
+public:
+    /// \return false if the framebuffer is incomplete; needs a current context
+    bool Create(int width, int height);
+    void Destroy();
+
+    /// \brief Makes it the draw and read framebuffer and sets the viewport to cover it
+    void Bind() const;
+
+    int GetWidth() const { return width; }
+    int GetHeight() const { return height; }
+
+private:
+    unsigned framebuffer = 0;
+    unsigned colorBuffer = 0;
+    unsigned depthBuffer = 0;
+    int width = 0;
+    int height = 0;
+};
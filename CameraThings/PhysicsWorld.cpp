@@ -0,0 +1,238 @@
+﻿#include "PhysicsWorld.h"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+#include "Profiler.h"
+
+namespace
+{
+    const size_t ContactBlockSize = 4096; // candidate pairs per narrow phase task
+}
+
+PhysicsWorld::PhysicsWorld(unsigned threadCount) : workers(threadCount)
+{
+    broadPhase = BroadPhase::Create(broadPhaseType);
+}
+
+void PhysicsWorld::SetBroadPhase(BroadPhaseType type)
+{
+    broadPhaseType = type;
+    broadPhase = BroadPhase::Create(type);
+}
+
+void PhysicsWorld::SetStaticGeometry(const std::vector<Aabb>& bounds)
+{
+    staticBounds = bounds;
+    staticGeometry.Build(bounds);
+}
+
+uint32_t PhysicsWorld::AddBody(const glm::vec3& position, const glm::vec3& velocity, float radius)
+{
+    positions.push_back(position);
+    previousPositions.push_back(position);
+    velocities.push_back(velocity);
+    radii.push_back(radius);
+    return static_cast<uint32_t>(positions.size() - 1);
+}
+
+int PhysicsWorld::Advance(float frameTime)
+{
+    if (positions.empty())
+    {
+        accumulator = 0.0f;
+        return 0;
+    }
+
+    accumulator += frameTime;
+    int steps = 0;
+    while (accumulator >= fixedTimeStep)
+    {
+        if (steps == maxStepsPerFrame)
+        {
+            accumulator = std::fmod(accumulator, fixedTimeStep);
+            break;
+        }
+        Step(fixedTimeStep);
+        accumulator -= fixedTimeStep;
+        steps++;
+    }
+    return steps;
+}
+
+void PhysicsWorld::GetInterpolatedPositions(std::vector<glm::vec3>& out)
+{
+    out.resize(positions.size());
+    const float alpha = GetAlpha();
+    workers.ParallelFor(positions.size(), 4096, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+            out[i] = glm::mix(previousPositions[i], positions[i], alpha);
+    });
+}
+
+void PhysicsWorld::Step(float dt)
+{
+    PROFILE_SCOPE("Physics step");
+    const size_t count = positions.size();
+    bounds.resize(count);
+    spheres.x.resize(count);
+    spheres.y.resize(count);
+    spheres.z.resize(count);
+    spheres.radius.resize(count);
+    workers.ParallelFor(count, 2048, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            bounds[i].min = positions[i] - glm::vec3(radii[i]);
+            bounds[i].max = positions[i] + glm::vec3(radii[i]);
+            spheres.x[i] = positions[i].x;
+            spheres.y[i] = positions[i].y;
+            spheres.z[i] = positions[i].z;
+            spheres.radius[i] = radii[i];
+        }
+    });
+
+    broadPhase->Update(bounds);
+    FindContacts();
+
+    // contacts per body, in pair order, so each body can be resolved on its own
+    contactStart.assign(count + 1, 0);
+    for (const CollisionPair& pair : contacts)
+    {
+        contactStart[pair.a + 1]++;
+        contactStart[pair.b + 1]++;
+    }
+    for (size_t i = 0; i < count; i++)
+        contactStart[i + 1] += contactStart[i];
+    contactOther.resize(contacts.size() * 2);
+    std::vector<uint32_t> cursor(contactStart.begin(), contactStart.end() - 1);
+    for (const CollisionPair& pair : contacts)
+    {
+        contactOther[cursor[pair.a]++] = pair.b;
+        contactOther[cursor[pair.b]++] = pair.a;
+    }
+
+    nextPositions.resize(count);
+    nextVelocities.resize(count);
+    workers.ParallelFor(count, 256, [&](size_t begin, size_t end)
+    {
+        std::vector<uint32_t> staticHits;
+        for (size_t i = begin; i < end; i++)
+            ResolveBody(static_cast<uint32_t>(i), dt, staticHits);
+    });
+
+    previousPositions.swap(positions);
+    positions.swap(nextPositions);
+    velocities.swap(nextVelocities);
+}
+
+/// \brief Narrow phase over the broad phase pairs in fixed size blocks, so the contact
+/// order is the same however the blocks are spread over threads
+void PhysicsWorld::FindContacts()
+{
+    PROFILE_SCOPE("Narrow phase");
+    const std::vector<CollisionPair>& candidates = broadPhase->GetPairs();
+    const size_t blockCount = (candidates.size() + ContactBlockSize - 1) / ContactBlockSize;
+    blockContacts.resize(blockCount);
+    workers.ParallelFor(blockCount, 1, [&](size_t begin, size_t end)
+    {
+        for (size_t block = begin; block < end; block++)
+        {
+            size_t first = block * ContactBlockSize;
+            size_t size = std::min(ContactBlockSize, candidates.size() - first);
+            NarrowPhase::FilterSpherePairs(spheres, candidates.data() + first, size, blockContacts[block]);
+        }
+    });
+
+    contacts.clear();
+    for (size_t block = 0; block < blockCount; block++)
+        contacts.insert(contacts.end(), blockContacts[block].begin(), blockContacts[block].end());
+}
+
+/// \brief Pushes one body out of everything it touches, bounces its velocity and integrates.
+/// Reads the current state of the other bodies and writes only this body's next state.
+void PhysicsWorld::ResolveBody(uint32_t body, float dt, std::vector<uint32_t>& staticHits)
+{
+    const glm::vec3 p = positions[body];
+    const float r = radii[body];
+    glm::vec3 v = velocities[body];
+    glm::vec3 correction(0.0f);
+
+    for (uint32_t k = contactStart[body]; k < contactStart[body + 1]; k++)
+    {
+        uint32_t other = contactOther[k];
+        glm::vec3 d = p - positions[other];
+        float distance = std::sqrt(glm::dot(d, d));
+        // coincident centres: split along x, opposite ways for the two bodies
+        glm::vec3 normal = distance > 1e-6f ? d / distance : glm::vec3(body < other ? 1.0f : -1.0f, 0.0f, 0.0f);
+
+        correction += normal * ((r + radii[other] - distance) * 0.5f);
+        float approach = glm::dot(v - velocities[other], normal);
+        if (approach < 0.0f)
+            v -= approach * normal; // equal mass elastic exchange along the normal
+    }
+
+    if (!staticBounds.empty())
+    {
+        Sphere sphere;
+        sphere.center = p;
+        sphere.radius = r;
+        staticHits.clear();
+        staticGeometry.QuerySphere(sphere, staticHits);
+        for (uint32_t hit : staticHits)
+        {
+            const Aabb& box = staticBounds[hit];
+            glm::vec3 d = p - glm::clamp(p, box.min, box.max);
+            float distance2 = glm::dot(d, d);
+            glm::vec3 normal;
+            float penetration;
+            if (distance2 > 1e-12f)
+            {
+                float distance = std::sqrt(distance2);
+                normal = d / distance;
+                penetration = r - distance;
+            }
+            else
+            {
+                // centre inside the box: leave through the nearest face
+                glm::vec3 toMin = p - box.min;
+                glm::vec3 toMax = box.max - p;
+                float best = 1e30f;
+                normal = glm::vec3(0.0f);
+                for (int a = 0; a < 3; a++)
+                {
+                    if (toMin[a] < best) { best = toMin[a]; normal = glm::vec3(0.0f); normal[a] = -1.0f; }
+                    if (toMax[a] < best) { best = toMax[a]; normal = glm::vec3(0.0f); normal[a] = 1.0f; }
+                }
+                penetration = best + r;
+            }
+            correction += normal * penetration;
+            float along = glm::dot(v, normal);
+            if (along < 0.0f)
+                v -= 2.0f * along * normal;
+        }
+    }
+
+    if (worldBounds.IsValid())
+    {
+        for (int a = 0; a < 3; a++)
+        {
+            if (p[a] - r < worldBounds.min[a])
+            {
+                correction[a] += worldBounds.min[a] - (p[a] - r);
+                v[a] = std::abs(v[a]);
+            }
+            else if (p[a] + r > worldBounds.max[a])
+            {
+                correction[a] -= (p[a] + r) - worldBounds.max[a];
+                v[a] = -std::abs(v[a]);
+            }
+        }
+    }
+
+    nextPositions[body] = p + correction + v * dt;
+    nextVelocities[body] = v;
+}
@@ -0,0 +1,78 @@
+﻿#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <glm/vec3.hpp>
+
+#include "BroadPhase.h"
+#include "Bvh.h"
+#include "NarrowPhase.h"
+#include "WorkerPool.h"
+
+/// \brief Moving spheres simulated with a fixed timestep, independent of the frame rate.
+/// Advance() is called once per rendered frame with the frame time and runs as many whole
+/// steps as have accumulated; the leftover fraction is used to interpolate positions for
+/// rendering. Every step reads only the previous step's state and each body writes only
+/// its own, so results are identical for any thread count.
+class PhysicsWorld
+{
+public:
+    const float fixedTimeStep = 1.0f / 120.0f;
+    const int maxStepsPerFrame = 8; // drop time rather than spiral when a frame is very long
+
+    explicit PhysicsWorld(unsigned threadCount = 0);
+
+    void SetBroadPhase(BroadPhaseType type);
+    BroadPhaseType GetBroadPhaseType() const { return broadPhaseType; }
+
+    /// \brief Bodies bounce off the inside of this box
+    void SetWorldBounds(const Aabb& bounds) { worldBounds = bounds; }
+
+    /// \brief Static boxes (Kube objects, imported meshes) the bodies collide with
+    void SetStaticGeometry(const std::vector<Aabb>& bounds);
+
+    uint32_t AddBody(const glm::vec3& position, const glm::vec3& velocity, float radius);
+    size_t GetBodyCount() const { return positions.size(); }
+
+    /// \brief Runs the fixed steps that fit in the accumulated time
+    /// \param frameTime render time since the last call, in seconds
+    /// \return number of steps run
+    int Advance(float frameTime);
+
+    /// \brief How far between the last two steps the current frame is, 0..1
+    float GetAlpha() const { return accumulator / fixedTimeStep; }
+
+    /// \brief Positions blended between the last two steps by GetAlpha(), for rendering
+    void GetInterpolatedPositions(std::vector<glm::vec3>& out);
+
+    const std::vector<glm::vec3>& GetPositions() const { return positions; }
+    const std::vector<float>& GetRadii() const { return radii; }
+
+private:
+    WorkerPool workers;
+    BroadPhaseType broadPhaseType = BroadPhaseType::Grid;
+    std::unique_ptr<BroadPhase> broadPhase;
+    Bvh staticGeometry;
+    std::vector<Aabb> staticBounds;
+    Aabb worldBounds;
+    float accumulator = 0.0f;
+
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> previousPositions;
+    std::vector<glm::vec3> velocities;
+    std::vector<float> radii;
+
+    // scratch buffers reused every step
+    std::vector<glm::vec3> nextPositions;
+    std::vector<glm::vec3> nextVelocities;
+    std::vector<Aabb> bounds;
+    SphereSoA spheres;
+    std::vector<std::vector<CollisionPair>> blockContacts;
+    std::vector<CollisionPair> contacts;
+    std::vector<uint32_t> contactStart;
+    std::vector<uint32_t> contactOther;
+
+    void Step(float dt);
+    void FindContacts();
+    void ResolveBody(uint32_t body, float dt, std::vector<uint32_t>& staticHits);
+};
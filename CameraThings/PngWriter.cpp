@@ -0,0 +1,111 @@
+﻿#include "PngWriter.h"
+
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    uint32_t Crc32(const uint8_t* data, size_t length, uint32_t crc = 0)
+    {
+        static uint32_t table[256];
+        static bool tableReady = false;
+        if (!tableReady)
+        {
+            for (uint32_t n = 0; n < 256; n++)
+            {
+                uint32_t c = n;
+                for (int k = 0; k < 8; k++)
+                    c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                table[n] = c;
+            }
+            tableReady = true;
+        }
+        crc = ~crc;
+        for (size_t i = 0; i < length; i++)
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    void PutBigEndian(std::vector<uint8_t>& out, uint32_t value)
+    {
+        out.push_back(static_cast<uint8_t>(value >> 24));
+        out.push_back(static_cast<uint8_t>(value >> 16));
+        out.push_back(static_cast<uint8_t>(value >> 8));
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    void WriteChunk(std::ofstream& file, const char type[4], const std::vector<uint8_t>& data)
+    {
+        std::vector<uint8_t> chunk;
+        PutBigEndian(chunk, static_cast<uint32_t>(data.size()));
+        chunk.insert(chunk.end(), type, type + 4);
+        chunk.insert(chunk.end(), data.begin(), data.end());
+        // the CRC covers type and data, not the length
+        PutBigEndian(chunk, Crc32(chunk.data() + 4, chunk.size() - 4));
+        file.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+    }
+}
+
+bool PngWriter::Write(const std::string& path, int width, int height, const uint8_t* rgba)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        std::cout << "ERROR::PNG::CANNOT_OPEN " << path << std::endl;
+        return false;
+    }
+
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    file.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+    std::vector<uint8_t> header;
+    PutBigEndian(header, static_cast<uint32_t>(width));
+    PutBigEndian(header, static_cast<uint32_t>(height));
+    header.push_back(8); // bits per channel
+    header.push_back(6); // RGBA
+    header.push_back(0); // deflate
+    header.push_back(0); // adaptive filtering (every row uses filter 0)
+    header.push_back(0); // not interlaced
+    WriteChunk(file, "IHDR", header);
+
+    // scanlines: a filter byte followed by the row
+    const size_t rowBytes = static_cast<size_t>(width) * 4;
+    std::vector<uint8_t> raw;
+    raw.reserve((rowBytes + 1) * height);
+    for (int y = 0; y < height; y++)
+    {
+        raw.push_back(0);
+        raw.insert(raw.end(), rgba + y * rowBytes, rgba + (y + 1) * rowBytes);
+    }
+
+    // zlib stream of stored blocks, at most 65535 bytes each
+    std::vector<uint8_t> compressed;
+    compressed.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+    compressed.push_back(0x78);
+    compressed.push_back(0x01);
+    uint32_t adlerA = 1, adlerB = 0;
+    size_t offset = 0;
+    do
+    {
+        size_t length = raw.size() - offset < 65535 ? raw.size() - offset : 65535;
+        bool last = offset + length == raw.size();
+        compressed.push_back(last ? 1 : 0);
+        compressed.push_back(static_cast<uint8_t>(length));
+        compressed.push_back(static_cast<uint8_t>(length >> 8));
+        compressed.push_back(static_cast<uint8_t>(~length));
+        compressed.push_back(static_cast<uint8_t>(~length >> 8));
+        for (size_t i = offset; i < offset + length; i++)
+        {
+            adlerA = (adlerA + raw[i]) % 65521;
+            adlerB = (adlerB + adlerA) % 65521;
+        }
+        compressed.insert(compressed.end(), raw.begin() + offset, raw.begin() + offset + length);
+        offset += length;
+    } while (offset < raw.size());
+    PutBigEndian(compressed, (adlerB << 16) | adlerA);
+    WriteChunk(file, "IDAT", compressed);
+
+    WriteChunk(file, "IEND", std::vector<uint8_t>());
+    return file.good();
+}
@@ -0,0 +1,12 @@
+﻿#pragma once
+#include <cstdint>
+#include <string>
+
+/// \brief Minimal PNG output for frame dumps: 8-bit RGBA, no filtering, stored (uncompressed)
+/// deflate blocks. Files are big but need no zlib and any viewer opens them.
+namespace PngWriter
+{
+    /// \param rgba width * height * 4 bytes, top row first
+    /// \return false if the file could not be written
+    bool Write(const std::string& path, int width, int height, const uint8_t* rgba);
+}
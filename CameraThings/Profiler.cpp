@@ -0,0 +1,269 @@
+﻿#include "Profiler.h"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <glad/glad.h>
+
+namespace
+{
+    struct Event
+    {
+        const char* name;
+        uint64_t start;    // ns since the profiler's epoch
+        uint64_t duration; // ns
+    };
+
+    /// \brief Events of one thread. Only the owning thread appends; count is published with
+    /// release so the exporter can read the filled part at any time.
+    struct Chunk
+    {
+        static const uint32_t Capacity = 4096;
+        Event events[Capacity];
+        std::atomic<uint32_t> count{0};
+        std::atomic<Chunk*> next{nullptr};
+    };
+
+    struct ThreadBuffer
+    {
+        uint32_t id;
+        Chunk first;
+        Chunk* current = &first;
+
+        ~ThreadBuffer()
+        {
+            Chunk* chunk = first.next.load();
+            while (chunk)
+            {
+                Chunk* next = chunk->next.load();
+                delete chunk;
+                chunk = next;
+            }
+        }
+
+        void Append(const Event& event)
+        {
+            uint32_t count = current->count.load(std::memory_order_relaxed);
+            if (count == Chunk::Capacity)
+            {
+                Chunk* chunk = new Chunk();
+                current->next.store(chunk, std::memory_order_release);
+                current = chunk;
+                count = 0;
+            }
+            current->events[count] = event;
+            current->count.store(count + 1, std::memory_order_release);
+        }
+    };
+
+    /// \brief Queries of one frame, reused FrameLatency frames later
+    struct GpuFrame
+    {
+        std::vector<unsigned> queries;
+        std::vector<Event> events; // duration filled in on read back
+        size_t used = 0;
+    };
+
+    std::atomic<bool> recording(false);
+    const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+    // buffers are registered once per thread and live until exit, so recording never locks
+    std::mutex registryMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> threadBuffers;
+    thread_local ThreadBuffer* threadBuffer = nullptr;
+
+    // GL thread only
+    bool gpuEnabled = false;
+    bool gpuScopeOpen = false;
+    GpuFrame gpuFrames[Profiler::FrameLatency];
+    unsigned gpuFrame = 0;
+    std::vector<Event> gpuEvents;
+
+    uint64_t Now()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+    }
+
+    ThreadBuffer& GetThreadBuffer()
+    {
+        if (threadBuffer == nullptr)
+        {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            threadBuffers.emplace_back(new ThreadBuffer());
+            threadBuffer = threadBuffers.back().get();
+            threadBuffer->id = static_cast<uint32_t>(threadBuffers.size());
+        }
+        return *threadBuffer;
+    }
+
+    /// \brief Moves a frame's finished queries into gpuEvents
+    /// \param wait block until the results are there instead of leaving them for later
+    void ReadGpuFrame(GpuFrame& frame, bool wait)
+    {
+        if (frame.used == 0)
+            return;
+        if (!wait)
+        {
+            GLint available = 0;
+            glGetQueryObjectiv(frame.queries[frame.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                return;
+        }
+        for (size_t i = 0; i < frame.used; i++)
+        {
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &elapsed);
+            frame.events[i].duration = elapsed;
+            gpuEvents.push_back(frame.events[i]);
+        }
+        frame.used = 0;
+    }
+
+    void WriteEscaped(std::ofstream& out, const char* text)
+    {
+        for (; *text; text++)
+        {
+            if (*text == '"' || *text == '\\')
+                out << '\\';
+            out << *text;
+        }
+    }
+
+    void WriteEvent(std::ofstream& out, const Event& event, uint32_t thread, bool& first)
+    {
+        out << (first ? "\n" : ",\n") << "{\"name\":\"";
+        WriteEscaped(out, event.name);
+        // trace timestamps are microseconds
+        out << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread
+            << ",\"ts\":" << event.start / 1000.0 << ",\"dur\":" << event.duration / 1000.0 << "}";
+        first = false;
+    }
+}
+
+void Profiler::Start()
+{
+#if !defined(CAMERATHINGS_PROFILER)
+    std::cout << "Profiler: built without CAMERATHINGS_PROFILER, the trace will be empty" << std::endl;
+#endif
+    GetThreadBuffer(); // the thread that starts recording is the trace's "Main"
+    recording.store(true, std::memory_order_relaxed);
+}
+
+void Profiler::Stop()
+{
+    recording.store(false, std::memory_order_relaxed);
+}
+
+bool Profiler::IsRecording()
+{
+    return recording.load(std::memory_order_relaxed);
+}
+
+void Profiler::EnableGpu()
+{
+    gpuEnabled = true;
+}
+
+void Profiler::EndFrame()
+{
+    if (!gpuEnabled)
+        return;
+    gpuFrame = (gpuFrame + 1) % FrameLatency;
+    // the oldest frame's slot is about to be reused; its results are normally long done
+    ReadGpuFrame(gpuFrames[gpuFrame], true);
+    for (unsigned i = 1; i < FrameLatency; i++)
+        ReadGpuFrame(gpuFrames[(gpuFrame + i) % FrameLatency], false);
+}
+
+bool Profiler::WriteChromeTrace(const std::string& path)
+{
+    if (gpuEnabled)
+    {
+        for (GpuFrame& frame : gpuFrames)
+            ReadGpuFrame(frame, true);
+    }
+
+    std::ofstream out(path);
+    if (!out)
+    {
+        std::cout << "ERROR::PROFILER::FILE_NOT_WRITABLE " << path << std::endl;
+        return false;
+    }
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    out << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"GPU\"}}";
+    first = false;
+    for (const Event& event : gpuEvents)
+        WriteEvent(out, event, 0, first);
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    size_t eventCount = gpuEvents.size();
+    for (const std::unique_ptr<ThreadBuffer>& buffer : threadBuffers)
+    {
+        out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->id
+            << ",\"args\":{\"name\":\"" << (buffer->id == 1 ? "Main" : "Worker") << "\"}}";
+        for (const Chunk* chunk = &buffer->first; chunk; chunk = chunk->next.load(std::memory_order_acquire))
+        {
+            const uint32_t count = chunk->count.load(std::memory_order_acquire);
+            for (uint32_t i = 0; i < count; i++)
+                WriteEvent(out, chunk->events[i], buffer->id, first);
+            eventCount += count;
+        }
+    }
+    out << "\n]}\n";
+    std::cout << "Profile: " << eventCount << " events written to " << path << std::endl;
+    return static_cast<bool>(out);
+}
+
+Profiler::CpuScope::CpuScope(const char* name) : name(name), start(0)
+{
+    if (recording.load(std::memory_order_relaxed))
+        start = Now() + 1; // 0 means not recording
+}
+
+Profiler::CpuScope::~CpuScope()
+{
+    if (start == 0)
+        return;
+    const uint64_t end = Now();
+    Event event;
+    event.name = name;
+    event.start = start - 1;
+    event.duration = end - event.start;
+    GetThreadBuffer().Append(event);
+}
+
+Profiler::GpuScope::GpuScope(const char* name) : active(false)
+{
+    if (!gpuEnabled || gpuScopeOpen || !recording.load(std::memory_order_relaxed))
+        return;
+
+    GpuFrame& frame = gpuFrames[gpuFrame];
+    if (frame.used == frame.queries.size())
+    {
+        unsigned query = 0;
+        glGenQueries(1, &query);
+        frame.queries.push_back(query);
+        frame.events.push_back(Event());
+    }
+    // placed on the trace at the CPU time the commands were issued, the length is the GPU's
+    frame.events[frame.used].name = name;
+    frame.events[frame.used].start = Now();
+    glBeginQuery(GL_TIME_ELAPSED, frame.queries[frame.used]);
+    frame.used++;
+    gpuScopeOpen = true;
+    active = true;
+}
+
+Profiler::GpuScope::~GpuScope()
+{
+    if (!active)
+        return;
+    glEndQuery(GL_TIME_ELAPSED);
+    gpuScopeOpen = false;
+}
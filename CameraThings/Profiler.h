@@ -0,0 +1,65 @@
+﻿#pragma once
+#include <cstdint>
+#include <string>
+
+// Scope markers compile to nothing unless CAMERATHINGS_PROFILER is defined. The project defines
+// it in every configuration, Release included, since only optimised frames show where the time
+// really goes. Compiled in, a marker costs one relaxed atomic load while nothing is being
+// recorded, and two clock reads plus an append to the calling thread's own buffer while
+// recording. Names must be string literals.
+#if defined(CAMERATHINGS_PROFILER)
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) Profiler::CpuScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_GPU_SCOPE(name) Profiler::GpuScope PROFILE_CONCAT(profileGpuScope, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_GPU_SCOPE(name) ((void)0)
+#endif
+
+/// \brief CPU scopes from any thread and GPU scopes from the GL thread, exported as a
+/// Chrome trace (chrome://tracing, Perfetto). Every thread records into its own buffer
+/// without locks; GPU scopes are GL_TIME_ELAPSED queries from a pool that is read back
+/// FrameLatency frames later, so reading them never waits for the GPU.
+namespace Profiler
+{
+    static const unsigned FrameLatency = 4;
+
+    void Start();
+    void Stop();
+    bool IsRecording();
+
+    /// \brief Allows GPU scopes; call with a current context, before Start or while recording
+    void EnableGpu();
+
+    /// \brief Call once per frame on the GL thread, after the frame's GPU scopes. Reads back
+    /// the queries of the frame FrameLatency frames ago.
+    void EndFrame();
+
+    /// \brief Waits for outstanding GPU results, then writes everything recorded
+    /// \return false if the file could not be written
+    bool WriteChromeTrace(const std::string& path);
+
+    class CpuScope
+    {
+    public:
+        explicit CpuScope(const char* name);
+        ~CpuScope();
+
+    private:
+        const char* name;
+        uint64_t start; // 0 when not recording
+    };
+
+    /// \brief GL_TIME_ELAPSED around the GL commands issued in the scope. GL allows only one
+    /// such query at a time, so GPU scopes must not nest; an inner one records nothing.
+    class GpuScope
+    {
+    public:
+        explicit GpuScope(const char* name);
+        ~GpuScope();
+
+    private:
+        bool active;
+    };
+}
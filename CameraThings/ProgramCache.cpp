@@ -0,0 +1,136 @@
+﻿#include "ProgramCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <glad/glad.h>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#include "GlExtensions.h"
+
+namespace
+{
+    const char Magic[4] = { 'P', 'B', 'I', 'N' };
+
+    struct Header
+    {
+        char magic[4];
+        uint32_t format;
+        uint32_t length;
+    };
+
+    void HashBytes(uint64_t& hash, const char* bytes, size_t length)
+    {
+        for (size_t i = 0; i < length; i++)
+            hash = (hash ^ static_cast<uint8_t>(bytes[i])) * 1099511628211ull;
+        // separator so ("ab", "c") and ("a", "bc") differ
+        hash = (hash ^ 0xffu) * 1099511628211ull;
+    }
+
+    void HashString(uint64_t& hash, const char* text)
+    {
+        HashBytes(hash, text ? text : "", text ? std::strlen(text) : 0);
+    }
+}
+
+ProgramCache::ProgramCache(const std::string& directory) : directory(directory)
+{
+}
+
+bool ProgramCache::IsEnabled() const
+{
+    return enabled && GlExtensions::hasProgramBinary;
+}
+
+uint64_t ProgramCache::MakeKey(const std::vector<const char*>& sources) const
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (const char* source : sources)
+        HashString(hash, source);
+    HashString(hash, reinterpret_cast<const char*>(glGetString(GL_VENDOR)));
+    HashString(hash, reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+    HashString(hash, reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+    return hash;
+}
+
+std::string ProgramCache::PathFor(uint64_t key) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+    return directory + "/" + name;
+}
+
+unsigned ProgramCache::Load(uint64_t key) const
+{
+    if (!IsEnabled())
+        return 0;
+
+    std::ifstream file(PathFor(key), std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+        return 0;
+    const std::streamoff fileSize = file.tellg();
+    file.seekg(0);
+
+    Header header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || std::memcmp(header.magic, Magic, sizeof(Magic)) != 0)
+        return 0;
+    // a truncated or corrupt entry must not size the allocation
+    if (header.length == 0 || std::streamoff(header.length) > fileSize - std::streamoff(sizeof(header)))
+        return 0;
+    std::vector<char> binary(header.length);
+    file.read(binary.data(), binary.size());
+    if (!file)
+        return 0;
+
+    unsigned program = glCreateProgram();
+    GlExtensions::ProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+    int success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        // stale entry (driver changed in a way the version string did not show): rebuild
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+void ProgramCache::Store(uint64_t key, unsigned program) const
+{
+    if (!IsEnabled())
+        return;
+
+    int length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    Header header;
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    std::vector<char> binary(length);
+    GLsizei written = 0;
+    GLenum format = 0;
+    GlExtensions::GetProgramBinary(program, length, &written, &format, binary.data());
+    header.format = format;
+    header.length = static_cast<uint32_t>(written);
+
+#ifdef _WIN32
+    _mkdir(directory.c_str());
+#else
+    mkdir(directory.c_str(), 0755);
+#endif
+    std::ofstream file(PathFor(key), std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        std::cout << "Unable to write program cache entry: " << PathFor(key) << std::endl;
+        return;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(binary.data(), written);
+}
@@ -0,0 +1,33 @@
+﻿#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// \brief On-disk cache of linked program binaries (glGetProgramBinary / glProgramBinary).
+/// Entries are keyed by a hash of the shader sources and the GL vendor, renderer and
+/// version strings, so a driver update or a different GPU simply misses. Does nothing
+/// when the context cannot hand out program binaries.
+class ProgramCache
+{
+public:
+    explicit ProgramCache(const std::string& directory = "programcache");
+
+    bool IsEnabled() const;
+    void SetEnabled(bool enabled) { this->enabled = enabled; }
+
+    /// \brief Key for a program built from these sources on the current context
+    uint64_t MakeKey(const std::vector<const char*>& sources) const;
+
+    /// \brief Creates a program from a cached binary
+    /// \return the linked program, or 0 on a miss or if the driver rejected the binary
+    unsigned Load(uint64_t key) const;
+
+    /// \brief Saves a linked program that was built with the retrievable hint set
+    void Store(uint64_t key, unsigned program) const;
+
+private:
+    std::string directory;
+    bool enabled = true;
+
+    std::string PathFor(uint64_t key) const;
+};
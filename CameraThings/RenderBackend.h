@@ -0,0 +1,75 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
+
+class Camera;
+class CurveBatch;
+
+enum class PrimitiveType
+{
+    Points,
+    LineStrip,
+    Triangles
+};
+
+/// \brief How the segments of a wide line strip meet
+enum class LineJoin
+{
+    Miter,
+    Round // also rounds the strip's ends
+};
+
+/// \brief How Points primitives look
+enum class PointMode
+{
+    Square,      // screen-aligned squares of SetPointSize pixels, like plain GL points
+    Splat,       // round splats SetPointSize world units across, smaller with distance
+    BlendedSplat // splats whose surfaces are close together are blended instead of overlapping
+};
+
+/// \brief Vertex data owned by a backend, 0 is no mesh
+typedef uint32_t MeshHandle;
+
+/// \brief What the app draws with, independent of who draws it. Vertices are interleaved
+/// x, y, z, r, g, b floats (the layout FileManager::convertPointsToFloats produces) and go
+/// through projection * view * model like in Scene.vert.
+class RenderBackend
+{
+public:
+    static const size_t FloatsPerVertex = 6;
+
+    virtual ~RenderBackend() = default;
+    virtual const char* GetName() const = 0;
+
+    /// \param vertices may be null to only reserve vertexCount vertices for UpdateMesh
+    /// \param indices may be null; indexed meshes are drawn through their indices
+    /// \param dynamic the vertices are rewritten every frame the mesh is drawn; backends may
+    /// stream them and keep them only for the frame UpdateMesh was called in
+    virtual MeshHandle CreateMesh(const float* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount, bool dynamic) = 0;
+    /// \brief Replaces the first vertexCount vertices, which must fit in what was created
+    virtual void UpdateMesh(MeshHandle mesh, const float* vertices, size_t vertexCount) = 0;
+    virtual void DestroyMesh(MeshHandle mesh) = 0;
+
+    /// \brief Clears colour and depth and takes the camera matrices for the frame
+    virtual void BeginFrame(const Camera& camera, const glm::vec4& clearColor) = 0;
+    virtual void SetModel(const glm::mat4& model) = 0;
+    /// \param width in pixels, the same on every driver
+    virtual void SetLineWidth(float width) = 0;
+    virtual void SetLineJoin(LineJoin join) = 0;
+    /// \param size pixels in PointMode::Square, world units across otherwise
+    virtual void SetPointSize(float size) = 0;
+    virtual void SetPointMode(PointMode mode) = 0;
+    /// \param count vertices (or indices) from first; 0 draws the rest of the mesh
+    virtual void Draw(MeshHandle mesh, PrimitiveType type, size_t first = 0, size_t count = 0) = 0;
+    /// \brief Every curve of the batch as a line strip in its own colour, through its own
+    /// transform and then the model matrix, with the current line width
+    virtual void DrawCurves(const CurveBatch& batch) = 0;
+    /// \brief Everything drawn since BeginFrame is finished after this
+    virtual void EndFrame() = 0;
+
+    /// \brief The finished frame as RGBA, top row first
+    virtual void ReadPixels(int& width, int& height, std::vector<uint8_t>& rgba) = 0;
+};
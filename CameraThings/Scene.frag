@@ -0,0 +1,10 @@
+#version 330 core
+#include "SceneCommon.glsl"
+
+in vec3 ourColor;
+out vec4 FragColor;
+
+void main()
+{
+    FragColor = vec4(ourColor, 1.0);
+}
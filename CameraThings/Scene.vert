@@ -0,0 +1,50 @@
+#version 330 core
+#include "SceneCommon.glsl"
+
+layout (location = 0) in vec3 aPos;
+#ifdef VERTEX_COLOR
+layout (location = 1) in vec3 aColor;
+#else
+uniform vec4 Color;
+#endif
+#ifdef INSTANCED
+layout (location = 2) in vec4 aInstance; // xyz offset, w scale
+#endif
+#ifdef CURVE_BATCH
+layout (location = 3) in uint aCurve;
+// 5 texels per curve: the transform's columns, then the colour (GlBackend::DrawCurves)
+uniform samplerBuffer curveData;
+#endif
+#ifdef PACKED_VERTEX
+// positions arrive as normalized integers in -1..1 and are mapped back to the data bounds
+uniform vec3 packScale;
+uniform vec3 packOffset;
+#endif
+
+out vec3 ourColor;
+
+void main()
+{
+    vec3 position = aPos;
+#ifdef PACKED_VERTEX
+    position = position * packScale + packOffset;
+#endif
+#ifdef INSTANCED
+    position = position * aInstance.w + aInstance.xyz;
+#endif
+#ifdef CURVE_BATCH
+    int curve = int(aCurve) * 5;
+    mat4 curveTransform = mat4(texelFetch(curveData, curve), texelFetch(curveData, curve + 1),
+                               texelFetch(curveData, curve + 2), texelFetch(curveData, curve + 3));
+    gl_Position = viewProjection * model * curveTransform * vec4(position, 1.0);
+#else
+    gl_Position = viewProjection * model * vec4(position, 1.0);
+#endif
+#if defined(CURVE_BATCH)
+    ourColor = texelFetch(curveData, curve + 4).rgb;
+#elif defined(VERTEX_COLOR)
+    ourColor = aColor;
+#else
+    ourColor = Color.rgb;
+#endif
+}
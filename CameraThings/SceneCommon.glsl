@@ -0,0 +1,12 @@
+// shared by every Scene.vert / Scene.frag permutation
+
+// per-frame camera data, one buffer for all programs (CameraUniformBuffer)
+layout (std140) uniform CameraBlock
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+};
+
+uniform mat4 model;
@@ -1,5 +1,12 @@
 ﻿#include "Shader.h"
+#include <algorithm>
 #include <iostream>
+#include <string>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "CameraUniformBuffer.h"
+#include "GlExtensions.h"
+#include "ProgramCache.h"
 
 void Shader::CreateVertexShader(const char* vertexShaderSource)
 {
@@ -36,19 +43,199 @@ void Shader::LinkProgram()
     shaderProgram = glCreateProgram();
     glAttachShader(shaderProgram, vertexShader);
     glAttachShader(shaderProgram, fragmentShader);
+    // lets ProgramCache read the binary back after linking
+    if (GlExtensions::hasProgramBinary)
+        GlExtensions::ProgramParameteri(shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(shaderProgram);
     int success;
     char infoLog[512];
     glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+    linked = success != 0;
     if (!success) {
         glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
         std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
     }
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
+    IntrospectUniforms();
+}
+
+/// \brief Asks GL once for every active uniform and keeps name hash -> location in a flat table.
+/// Also attaches the shared camera block to its fixed binding point (GLSL 3.30 cannot say so itself).
+void Shader::IntrospectUniforms()
+{
+    uniforms.clear();
+    unsigned cameraBlock = glGetUniformBlockIndex(shaderProgram, CameraUniformBuffer::BlockName);
+    if (cameraBlock != GL_INVALID_INDEX)
+        glUniformBlockBinding(shaderProgram, cameraBlock, CameraUniformBuffer::BindingPoint);
+
+    int count = 0;
+    int maxLength = 0;
+    glGetProgramiv(shaderProgram, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(shaderProgram, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    std::vector<char> name(std::max(maxLength, 1));
+    for (int i = 0; i < count; i++)
+    {
+        int length = 0, size = 0;
+        GLenum type;
+        glGetActiveUniform(shaderProgram, i, (GLsizei)name.size(), &length, &size, &type, name.data());
+        int location = glGetUniformLocation(shaderProgram, name.data());
+        if (location < 0)
+            continue; // members of uniform blocks have no location
+
+        // arrays are reported as "name[0]", look them up by the bare name
+        std::string uniformName(name.data(), length);
+        if (uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0)
+            uniformName.resize(uniformName.size() - 3);
+
+        UniformEntry entry;
+        entry.hash = Uniform(uniformName.c_str()).hash;
+        entry.location = location;
+        uniforms.push_back(entry);
+    }
+
+    std::sort(uniforms.begin(), uniforms.end(), [](const UniformEntry& a, const UniformEntry& b) { return a.hash < b.hash; });
+    for (size_t i = 1; i < uniforms.size(); i++)
+    {
+        if (uniforms[i].hash == uniforms[i - 1].hash)
+            std::cout << "WARNING::SHADER::UNIFORM_HASH_COLLISION" << std::endl;
+    }
+}
+
+int Shader::GetUniformLocation(UniformHandle handle) const
+{
+    auto it = std::lower_bound(uniforms.begin(), uniforms.end(), handle.hash,
+                               [](const UniformEntry& entry, uint32_t hash) { return entry.hash < hash; });
+    return it != uniforms.end() && it->hash == handle.hash ? it->location : -1;
+}
+
+void Shader::SetInt(UniformHandle handle, int value) const
+{
+    glUniform1i(GetUniformLocation(handle), value);
+}
+
+void Shader::SetFloat(UniformHandle handle, float value) const
+{
+    glUniform1f(GetUniformLocation(handle), value);
+}
+
+void Shader::SetVec2(UniformHandle handle, const glm::vec2& value) const
+{
+    glUniform2fv(GetUniformLocation(handle), 1, glm::value_ptr(value));
+}
+
+void Shader::SetVec3(UniformHandle handle, const glm::vec3& value) const
+{
+    glUniform3fv(GetUniformLocation(handle), 1, glm::value_ptr(value));
+}
+
+void Shader::SetVec4(UniformHandle handle, const glm::vec4& value) const
+{
+    glUniform4fv(GetUniformLocation(handle), 1, glm::value_ptr(value));
+}
+
+void Shader::SetMat4(UniformHandle handle, const glm::mat4& value) const
+{
+    glUniformMatrix4fv(GetUniformLocation(handle), 1, GL_FALSE, glm::value_ptr(value));
 }
 
 unsigned int Shader::GetProgram()
 {
     return shaderProgram;
-}
\ No newline at end of file
+}
+
+bool Shader::Build(const char* vertexShaderSource, const char* fragmentShaderSource, const ProgramCache* cache)
+{
+    bool fromCache = BeginBuild(vertexShaderSource, fragmentShaderSource, cache);
+    WaitForBuild();
+    return fromCache;
+}
+
+bool Shader::BeginBuild(const char* vertexShaderSource, const char* fragmentShaderSource, const ProgramCache* cache)
+{
+    pending = false;
+    buildCache = nullptr;
+    if (cache && cache->IsEnabled())
+    {
+        buildKey = cache->MakeKey({ vertexShaderSource, fragmentShaderSource });
+        unsigned program = cache->Load(buildKey);
+        if (program != 0)
+        {
+            shaderProgram = program;
+            linked = true;
+            IntrospectUniforms();
+            return true;
+        }
+        buildCache = cache;
+    }
+
+    vertexShader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
+    glCompileShader(vertexShader);
+    fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
+    glCompileShader(fragmentShader);
+
+    shaderProgram = glCreateProgram();
+    glAttachShader(shaderProgram, vertexShader);
+    glAttachShader(shaderProgram, fragmentShader);
+    if (GlExtensions::hasProgramBinary)
+        GlExtensions::ProgramParameteri(shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    // a failed compile just makes the link fail, which is checked in WaitForBuild
+    glLinkProgram(shaderProgram);
+    pending = true;
+    return false;
+}
+
+bool Shader::IsReady()
+{
+    if (!pending)
+        return true;
+    if (GlExtensions::hasParallelShaderCompile)
+    {
+        int done = 0;
+        glGetProgramiv(shaderProgram, GL_COMPLETION_STATUS_KHR, &done);
+        if (!done)
+            return false;
+    }
+    WaitForBuild();
+    return true;
+}
+
+void Shader::WaitForBuild()
+{
+    if (!pending)
+        return;
+    pending = false;
+
+    int success;
+    char infoLog[512];
+    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+    linked = success != 0;
+    if (!linked)
+    {
+        // only now look at the stages, to say which one broke
+        glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+        }
+        glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+        }
+        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+    }
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    IntrospectUniforms();
+
+    if (linked && buildCache)
+        buildCache->Store(buildKey, shaderProgram);
+    buildCache = nullptr;
+}
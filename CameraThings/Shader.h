@@ -1,5 +1,16 @@
 ﻿#pragma once
+#include <cstdint>
+#include <vector>
 #include <glad/glad.h>
+#include <glm/fwd.hpp>
+
+class ProgramCache;
+
+/// \brief A uniform name hashed ahead of time (FNV-1a), so lookups never touch strings
+struct UniformHandle
+{
+    uint32_t hash;
+};
 
 class Shader
 {
@@ -8,9 +19,63 @@ private:
     unsigned int fragmentShader;
     unsigned int shaderProgram;
 
+    struct UniformEntry
+    {
+        uint32_t hash;
+        int location;
+    };
+    std::vector<UniformEntry> uniforms; // every active uniform, sorted by hash
+
+    // an asynchronous build that was submitted but whose status has not been read yet
+    bool pending = false;
+    bool linked = false;
+    const ProgramCache* buildCache = nullptr;
+    uint64_t buildKey = 0;
+
+    void IntrospectUniforms();
+
 public:
     void CreateVertexShader(const char* vertexShaderSource);
     void CreateFragmentShader(const char* fragmentShaderSource);
     void LinkProgram();
     unsigned int GetProgram();
-};
\ No newline at end of file
+
+    /// \brief Compiles and links both stages, or loads the linked program from the cache
+    /// \param cache may be null to always compile
+    /// \return true if the program came from the cache
+    bool Build(const char* vertexShaderSource, const char* fragmentShaderSource, const ProgramCache* cache);
+
+    /// \brief Submits compile and link without reading any status back, so the driver can
+    /// work on many programs at once. Finish with IsReady() or WaitForBuild().
+    /// \return true if the program came from the cache (it is then ready at once)
+    bool BeginBuild(const char* vertexShaderSource, const char* fragmentShaderSource, const ProgramCache* cache);
+
+    /// \brief Non-blocking with KHR_parallel_shader_compile; without it the first call waits
+    /// \return true once the build has finished, successfully or not
+    bool IsReady();
+
+    /// \brief Blocks until the build has finished, then reports errors and fills the uniform table
+    void WaitForBuild();
+
+    /// \brief False if the last build failed to compile or link
+    bool IsLinked() const { return linked; }
+
+    static constexpr UniformHandle Uniform(const char* name)
+    {
+        uint32_t hash = 2166136261u;
+        while (*name)
+            hash = (hash ^ static_cast<uint8_t>(*name++)) * 16777619u;
+        return UniformHandle{ hash };
+    }
+
+    /// \brief Location from the table built after linking, -1 if the program has no such uniform
+    int GetUniformLocation(UniformHandle handle) const;
+
+    // typed setters for the program currently in use; unknown uniforms are ignored like in GL
+    void SetInt(UniformHandle handle, int value) const;
+    void SetFloat(UniformHandle handle, float value) const;
+    void SetVec2(UniformHandle handle, const glm::vec2& value) const;
+    void SetVec3(UniformHandle handle, const glm::vec3& value) const;
+    void SetVec4(UniformHandle handle, const glm::vec4& value) const;
+    void SetMat4(UniformHandle handle, const glm::mat4& value) const;
+};
@@ -0,0 +1,160 @@
+﻿#include "ShaderLibrary.h"
+
+#include <algorithm>
+#include <iostream>
+#include <glad/glad.h>
+
+std::vector<std::string> ShaderLibrary::DefinesFor(uint32_t features)
+{
+    std::vector<std::string> defines;
+    if (features & ShaderFeatureInstanced)
+        defines.push_back("INSTANCED");
+    if (features & ShaderFeaturePackedVertex)
+        defines.push_back("PACKED_VERTEX");
+    if (features & ShaderFeatureVertexColor)
+        defines.push_back("VERTEX_COLOR");
+    if (features & ShaderFeatureCurveBatch)
+        defines.push_back("CURVE_BATCH");
+    return defines;
+}
+
+Shader* ShaderLibrary::Get(const std::string& vertexFile, const std::string& fragmentFile, uint32_t features)
+{
+    Shader* shader = Request(vertexFile, fragmentFile, features);
+    if (shader)
+        shader->WaitForBuild();
+    return shader;
+}
+
+bool ShaderLibrary::Poll()
+{
+    pending.erase(std::remove_if(pending.begin(), pending.end(), [](Shader* shader) { return shader->IsReady(); }),
+                  pending.end());
+    return pending.empty();
+}
+
+Shader* ShaderLibrary::Request(const std::string& vertexFile, const std::string& fragmentFile, uint32_t features)
+{
+    Key key{ vertexFile, fragmentFile, features };
+    auto found = programs.find(key);
+    if (found != programs.end())
+        return found->second.shader.get();
+
+    Entry entry;
+    bool fromCache = false;
+    entry.shader = Submit(key, entry.dependencies, fromCache);
+    if (!entry.shader)
+        return nullptr;
+
+    if (fromCache)
+        cacheHits++;
+    else
+        pending.push_back(entry.shader.get());
+    if (watcher)
+    {
+        for (const std::string& file : entry.dependencies)
+            watcher->Watch(file);
+    }
+    Shader* result = entry.shader.get();
+    programs[key] = std::move(entry);
+    return result;
+}
+
+std::unique_ptr<Shader> ShaderLibrary::Submit(const Key& key, std::vector<std::string>& dependencies, bool& fromCache)
+{
+    std::vector<std::string> defines = DefinesFor(key.features);
+    std::string vertexSource;
+    std::string fragmentSource;
+    dependencies.clear();
+    if (!preprocessor.Preprocess(key.vertexFile, defines, vertexSource))
+        return nullptr;
+    dependencies = preprocessor.GetDependencies();
+    if (!preprocessor.Preprocess(key.fragmentFile, defines, fragmentSource))
+    {
+        std::cout << "ERROR::SHADER::LIBRARY::PREPROCESS_FAILED " << key.vertexFile << " + " << key.fragmentFile
+                  << " features " << key.features << std::endl;
+        return nullptr;
+    }
+    for (const std::string& file : preprocessor.GetDependencies())
+    {
+        if (std::find(dependencies.begin(), dependencies.end(), file) == dependencies.end())
+            dependencies.push_back(file);
+    }
+
+    std::unique_ptr<Shader> shader(new Shader());
+    fromCache = shader->BeginBuild(vertexSource.c_str(), fragmentSource.c_str(), cache);
+    return shader;
+}
+
+void ShaderLibrary::EnableHotReload()
+{
+    if (watcher)
+        return;
+    watcher.reset(new FileWatcher());
+    for (const auto& program : programs)
+    {
+        for (const std::string& file : program.second.dependencies)
+            watcher->Watch(file);
+    }
+}
+
+int ShaderLibrary::Update()
+{
+    if (!watcher)
+        return 0;
+
+    // start rebuilds; a program whose rebuild is still compiling starts over with the newer text
+    if (watcher->Poll(changedFiles))
+    {
+        for (auto& program : programs)
+        {
+            Entry& entry = program.second;
+            bool affected = false;
+            for (const std::string& file : changedFiles)
+                affected |= std::find(entry.dependencies.begin(), entry.dependencies.end(), file) != entry.dependencies.end();
+            if (!affected)
+                continue;
+
+            if (entry.replacement)
+            {
+                entry.replacement->WaitForBuild();
+                glDeleteProgram(entry.replacement->GetProgram());
+            }
+            std::vector<std::string> dependencies;
+            bool fromCache = false;
+            entry.replacement = Submit(program.first, dependencies, fromCache);
+            if (entry.replacement)
+            {
+                entry.dependencies = dependencies;
+                for (const std::string& file : dependencies)
+                    watcher->Watch(file); // a new #include
+            }
+        }
+    }
+
+    // swap in finished rebuilds
+    int swapped = 0;
+    for (auto& program : programs)
+    {
+        Entry& entry = program.second;
+        if (!entry.replacement || !entry.replacement->IsReady())
+            continue;
+
+        if (entry.replacement->IsLinked())
+        {
+            glDeleteProgram(entry.shader->GetProgram());
+            *entry.shader = std::move(*entry.replacement);
+            swapped++;
+            std::cout << "Reloaded " << program.first.vertexFile << " + " << program.first.fragmentFile
+                      << " features " << program.first.features << std::endl;
+        }
+        else
+        {
+            glDeleteProgram(entry.replacement->GetProgram());
+            std::cout << "Reload of " << program.first.vertexFile << " + " << program.first.fragmentFile
+                      << " failed, keeping the previous program" << std::endl;
+        }
+        entry.replacement.reset();
+    }
+    return swapped;
+}
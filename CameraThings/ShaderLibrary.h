@@ -0,0 +1,99 @@
+﻿#pragma once
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "FileWatcher.h"
+#include "Shader.h"
+#include "ShaderPreprocessor.h"
+
+class ProgramCache;
+
+/// \brief Optional features a shader source can be built with. Each set bit becomes a
+/// #define, so one source file gives a whole family of programs.
+enum ShaderFeature : uint32_t
+{
+    ShaderFeatureNone = 0,
+    ShaderFeatureInstanced = 1 << 0,   // INSTANCED: per-instance offset and scale in attribute 2
+    ShaderFeaturePackedVertex = 1 << 1, // PACKED_VERTEX: quantized positions, unpacked with packScale/packOffset
+    ShaderFeatureVertexColor = 1 << 2,  // VERTEX_COLOR: colour from attribute 1 instead of the Color uniform
+    ShaderFeatureCurveBatch = 1 << 3,   // CURVE_BATCH: per-curve transform and colour from curveData, curve index in attribute 3
+};
+
+/// \brief Builds shader permutations on demand. Only the combinations that are asked for
+/// get compiled, each once, and the linked programs go through the ProgramCache so later
+/// launches skip compiling them too.
+class ShaderLibrary
+{
+public:
+    /// \param cache may be null to always compile
+    explicit ShaderLibrary(const ProgramCache* cache) : cache(cache) {}
+
+    /// \brief The program for this source pair and feature set, built on first use
+    /// \return null if preprocessing failed; compile and link errors are printed by Shader
+    Shader* Get(const std::string& vertexFile, const std::string& fragmentFile, uint32_t features);
+
+    /// \brief Like Get, but only submits the build. Request everything that will be needed
+    /// first, then Poll() until it returns true; the driver compiles them side by side.
+    Shader* Request(const std::string& vertexFile, const std::string& fragmentFile, uint32_t features);
+
+    /// \brief Finishes whichever requested builds are done without waiting for the rest
+    /// \return true when no build is pending any more
+    bool Poll();
+
+    /// \brief Watches the source files (and their includes) of every program from now on
+    void EnableHotReload();
+
+    /// \brief Call once per frame, between frames. Starts rebuilding programs whose files
+    /// changed and swaps finished rebuilds in if they linked; a broken edit keeps the old
+    /// program. Shader pointers handed out stay valid, but GetProgram() may change.
+    /// \return number of programs swapped this call
+    int Update();
+
+    /// \brief #defines for a feature set, in bit order
+    static std::vector<std::string> DefinesFor(uint32_t features);
+
+    size_t GetProgramCount() const { return programs.size(); }
+
+    /// \brief How many of the built programs were loaded from the ProgramCache
+    size_t GetCacheHits() const { return cacheHits; }
+
+private:
+    struct Key
+    {
+        std::string vertexFile;
+        std::string fragmentFile;
+        uint32_t features;
+
+        bool operator<(const Key& other) const
+        {
+            if (features != other.features)
+                return features < other.features;
+            if (vertexFile != other.vertexFile)
+                return vertexFile < other.vertexFile;
+            return fragmentFile < other.fragmentFile;
+        }
+    };
+
+    struct Entry
+    {
+        std::unique_ptr<Shader> shader;
+        std::unique_ptr<Shader> replacement; // rebuild in flight
+        std::vector<std::string> dependencies;
+    };
+
+    const ProgramCache* cache;
+    ShaderPreprocessor preprocessor;
+    std::map<Key, Entry> programs;
+    std::vector<Shader*> pending;
+    size_t cacheHits = 0;
+
+    std::unique_ptr<FileWatcher> watcher;
+    std::vector<std::string> changedFiles;
+
+    /// \brief Preprocesses both stages and submits the build
+    /// \return null if preprocessing failed
+    std::unique_ptr<Shader> Submit(const Key& key, std::vector<std::string>& dependencies, bool& fromCache);
+};
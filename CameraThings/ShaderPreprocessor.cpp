@@ -0,0 +1,117 @@
+﻿#include "ShaderPreprocessor.h"
+
+#include <iostream>
+#include <sstream>
+
+#include "FileManager.h"
+
+namespace
+{
+    const int MaxIncludeDepth = 32;
+
+    std::string DirectoryOf(const std::string& path)
+    {
+        size_t slash = path.find_last_of("/\\");
+        return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+    }
+
+    /// \brief Returns the directive name if the line is a preprocessor line ("include", "version"...)
+    std::string DirectiveOf(const std::string& line, size_t& rest)
+    {
+        size_t i = line.find_first_not_of(" \t");
+        if (i == std::string::npos || line[i] != '#')
+            return std::string();
+        i = line.find_first_not_of(" \t", i + 1);
+        if (i == std::string::npos)
+            return std::string();
+        size_t end = line.find_first_of(" \t\r", i);
+        rest = end == std::string::npos ? line.size() : end;
+        return line.substr(i, rest - i);
+    }
+}
+
+bool ShaderPreprocessor::Preprocess(const std::string& filename, const std::vector<std::string>& defines, std::string& source)
+{
+    dependencies.clear();
+    included.clear();
+    version.clear();
+
+    std::string body;
+    if (!Expand(filename, 0, body))
+        return false;
+
+    std::ostringstream out;
+    out << (version.empty() ? "#version 330 core" : version) << "\n";
+    for (const std::string& define : defines)
+        out << "#define " << define << "\n";
+    // line numbers in compile errors refer to the top level file again
+    out << "#line 1 0\n";
+    out << body;
+    source = out.str();
+    return true;
+}
+
+bool ShaderPreprocessor::Expand(const std::string& filename, int depth, std::string& out)
+{
+    if (depth > MaxIncludeDepth)
+    {
+        std::cout << "ERROR::SHADER::PREPROCESSOR::INCLUDE_TOO_DEEP " << filename << std::endl;
+        return false;
+    }
+    if (!included.insert(filename).second)
+        return true; // already pulled in once
+
+    FileManager fileManager;
+    std::string text = fileManager.readFile(filename);
+    if (text.empty())
+    {
+        std::cout << "ERROR::SHADER::PREPROCESSOR::FILE_NOT_FOUND " << filename << std::endl;
+        return false;
+    }
+    // a leading UTF-8 byte order mark is not valid GLSL
+    if (text.compare(0, 3, "\xEF\xBB\xBF") == 0)
+        text.erase(0, 3);
+
+    const int sourceNumber = static_cast<int>(dependencies.size());
+    dependencies.push_back(filename);
+
+    std::istringstream lines(text);
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(lines, line))
+    {
+        lineNumber++;
+        size_t rest = 0;
+        std::string directive = DirectiveOf(line, rest);
+
+        if (directive == "version")
+        {
+            // hoisted to the top; only the first one counts
+            if (version.empty())
+                version = line.substr(line.find('#'));
+            out += "\n";
+            continue;
+        }
+
+        if (directive == "include")
+        {
+            size_t open = line.find('"', rest);
+            size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+            if (close == std::string::npos)
+            {
+                std::cout << "ERROR::SHADER::PREPROCESSOR::BAD_INCLUDE " << filename << ":" << lineNumber << std::endl;
+                return false;
+            }
+            std::string path = DirectoryOf(filename) + line.substr(open + 1, close - open - 1);
+            out += "#line 1 " + std::to_string(dependencies.size()) + "\n";
+            if (!Expand(path, depth + 1, out))
+                return false;
+            out += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(sourceNumber) + "\n";
+            continue;
+        }
+
+        out += line;
+        out += "\n";
+    }
+    return true;
+}
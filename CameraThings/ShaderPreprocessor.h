@@ -0,0 +1,27 @@
+﻿#pragma once
+#include <set>
+#include <string>
+#include <vector>
+
+/// \brief Turns one GLSL source file into compilable source: resolves #include "file"
+/// (relative to the including file, each file at most once), keeps #version as the first
+/// line and injects #defines right after it.
+class ShaderPreprocessor
+{
+public:
+    /// \param filename path of the top level shader file
+    /// \param defines names (or "NAME VALUE") to #define
+    /// \param source receives the result
+    /// \return false if a file was missing or includes nested too deep; the reason is printed
+    bool Preprocess(const std::string& filename, const std::vector<std::string>& defines, std::string& source);
+
+    /// \brief Every file read by the last Preprocess call, the top level file first
+    const std::vector<std::string>& GetDependencies() const { return dependencies; }
+
+private:
+    std::vector<std::string> dependencies;
+    std::set<std::string> included;
+    std::string version;
+
+    bool Expand(const std::string& filename, int depth, std::string& out);
+};
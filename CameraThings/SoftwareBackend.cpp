@@ -0,0 +1,147 @@
+﻿#include "SoftwareBackend.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Camera.h"
+#include "CurveBatch.h"
+
+SoftwareBackend::SoftwareBackend(int width, int height, unsigned threadCount)
+    : rasterizer(threadCount), viewProjection(1.0f), model(1.0f)
+{
+    rasterizer.Resize(width, height);
+}
+
+MeshHandle SoftwareBackend::CreateMesh(const float* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount, bool)
+{
+    Mesh mesh;
+    if (vertices)
+        mesh.vertices.assign(vertices, vertices + vertexCount * FloatsPerVertex);
+    else
+        mesh.vertices.resize(vertexCount * FloatsPerVertex, 0.0f);
+    if (indices)
+        mesh.indices.assign(indices, indices + indexCount);
+    meshes.push_back(std::move(mesh));
+    return static_cast<MeshHandle>(meshes.size());
+}
+
+void SoftwareBackend::UpdateMesh(MeshHandle handle, const float* vertices, size_t vertexCount)
+{
+    Mesh& mesh = meshes[handle - 1];
+    size_t floats = std::min(vertexCount * FloatsPerVertex, mesh.vertices.size());
+    std::copy(vertices, vertices + floats, mesh.vertices.begin());
+}
+
+void SoftwareBackend::DestroyMesh(MeshHandle handle)
+{
+    meshes[handle - 1] = Mesh();
+}
+
+void SoftwareBackend::BeginFrame(const Camera& camera, const glm::vec4& clearColor)
+{
+    viewProjection = camera.GetViewProjection();
+    projectionScale = camera.GetProjection()[1][1];
+    rasterizer.Clear(clearColor);
+}
+
+void SoftwareBackend::Draw(MeshHandle handle, PrimitiveType type, size_t first, size_t count)
+{
+    const Mesh& mesh = meshes[handle - 1];
+    const size_t vertexCount = mesh.vertices.size() / FloatsPerVertex;
+    const size_t total = mesh.indices.empty() ? vertexCount : mesh.indices.size();
+    if (first >= total)
+        return;
+    if (count == 0 || first + count > total)
+        count = total - first;
+
+    // the vertex stage: projection * view * model, like Scene.vert
+    const glm::mat4 transform = viewProjection * model;
+    transformed.resize(vertexCount);
+    rasterizer.GetWorkers().ParallelFor(vertexCount, 4096, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            const float* v = &mesh.vertices[i * FloatsPerVertex];
+            transformed[i].clip = transform * glm::vec4(v[0], v[1], v[2], 1.0f);
+            transformed[i].color = glm::vec3(v[3], v[4], v[5]);
+        }
+    });
+
+    auto vertex = [&](size_t i) -> const RasterVertex& { return transformed[mesh.indices.empty() ? i : mesh.indices[i]]; };
+    switch (type)
+    {
+    case PrimitiveType::Points:
+        for (size_t i = first; i < first + count; i++)
+        {
+            if (pointMode == PointMode::Square)
+                rasterizer.AddPoint(vertex(i));
+            else
+                AddSplat(vertex(i));
+        }
+        break;
+    case PrimitiveType::LineStrip:
+        for (size_t i = first + 1; i < first + count; i++)
+            rasterizer.AddLine(vertex(i - 1), vertex(i));
+        break;
+    case PrimitiveType::Triangles:
+        for (size_t i = first; i + 2 < first + count; i += 3)
+            rasterizer.AddTriangle(vertex(i), vertex(i + 1), vertex(i + 2));
+        break;
+    }
+}
+
+void SoftwareBackend::DrawCurves(const CurveBatch& batch)
+{
+    const std::vector<glm::vec3>& points = batch.GetPoints();
+    const std::vector<CurveBatch::Curve>& curves = batch.GetCurves();
+    transformed.resize(points.size());
+    rasterizer.GetWorkers().ParallelFor(curves.size(), 16, [&](size_t begin, size_t end)
+    {
+        for (size_t c = begin; c < end; c++)
+        {
+            const CurveBatch::Curve& curve = curves[c];
+            const glm::mat4 transform = viewProjection * model * curve.transform;
+            for (uint32_t i = curve.first; i < curve.first + curve.count; i++)
+            {
+                transformed[i].clip = transform * glm::vec4(points[i], 1.0f);
+                transformed[i].color = glm::vec3(curve.color);
+            }
+        }
+    });
+
+    for (const CurveBatch::Curve& curve : curves)
+    {
+        for (uint32_t i = curve.first + 1; i < curve.first + curve.count; i++)
+            rasterizer.AddLine(transformed[i - 1], transformed[i]);
+    }
+}
+
+/// \brief A flat octagon facing the screen, pointSize world units across like Splat.vert
+void SoftwareBackend::AddSplat(const RasterVertex& centre)
+{
+    const float w = centre.clip.w;
+    if (w <= 0.0f)
+        return;
+    // pixels across at this distance, then back to clip units
+    const float pixels = std::min(std::max(pointSize * projectionScale * 0.5f * rasterizer.GetHeight() / w, 1.0f), 256.0f);
+    const float radiusX = pixels / rasterizer.GetWidth() * w;
+    const float radiusY = pixels / rasterizer.GetHeight() * w;
+
+    RasterVertex rim[8];
+    for (int i = 0; i < 8; i++)
+    {
+        const float angle = i * 0.785398163f;
+        rim[i] = centre;
+        rim[i].clip.x += std::cos(angle) * radiusX;
+        rim[i].clip.y += std::sin(angle) * radiusY;
+    }
+    for (int i = 0; i < 8; i++)
+        rasterizer.AddTriangle(centre, rim[i], rim[(i + 1) % 8]);
+}
+
+void SoftwareBackend::ReadPixels(int& width, int& height, std::vector<uint8_t>& rgba)
+{
+    width = rasterizer.GetWidth();
+    height = rasterizer.GetHeight();
+    rasterizer.ReadPixels(rgba);
+}
@@ -0,0 +1,52 @@
+﻿#pragma once
+#include <vector>
+#include <glm/mat4x4.hpp>
+
+#include "RenderBackend.h"
+#include "SoftwareRasterizer.h"
+
+/// \brief RenderBackend that needs no GL at all: meshes live in memory, vertices are
+/// transformed on the worker threads and drawn by SoftwareRasterizer
+class SoftwareBackend : public RenderBackend
+{
+public:
+    /// \param threadCount total threads including the caller, 0 uses every hardware thread
+    SoftwareBackend(int width, int height, unsigned threadCount = 0);
+
+    const char* GetName() const override { return "software"; }
+
+    MeshHandle CreateMesh(const float* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount, bool dynamic) override;
+    void UpdateMesh(MeshHandle mesh, const float* vertices, size_t vertexCount) override;
+    void DestroyMesh(MeshHandle mesh) override;
+
+    void BeginFrame(const Camera& camera, const glm::vec4& clearColor) override;
+    void SetModel(const glm::mat4& model) override { this->model = model; }
+    void SetLineWidth(float width) override { rasterizer.SetLineWidth(width); }
+    void SetLineJoin(LineJoin) override {} // lines are separate butt-ended quads
+    void SetPointSize(float size) override { pointSize = size; rasterizer.SetPointSize(size); }
+    /// \brief Both splat modes give opaque round splats, there is no blending
+    void SetPointMode(PointMode mode) override { pointMode = mode; }
+    void Draw(MeshHandle mesh, PrimitiveType type, size_t first = 0, size_t count = 0) override;
+    void DrawCurves(const CurveBatch& batch) override;
+    void EndFrame() override { rasterizer.Flush(); }
+
+    void ReadPixels(int& width, int& height, std::vector<uint8_t>& rgba) override;
+
+private:
+    struct Mesh
+    {
+        std::vector<float> vertices;
+        std::vector<uint32_t> indices;
+    };
+
+    SoftwareRasterizer rasterizer;
+    glm::mat4 viewProjection;
+    glm::mat4 model;
+    float projectionScale = 1.0f; // projection[1][1]
+    float pointSize = 1.0f;
+    PointMode pointMode = PointMode::Square;
+    std::vector<Mesh> meshes; // handle - 1
+    std::vector<RasterVertex> transformed;
+
+    void AddSplat(const RasterVertex& centre);
+};
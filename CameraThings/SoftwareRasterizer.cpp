@@ -0,0 +1,328 @@
+﻿#include "SoftwareRasterizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "Profiler.h"
+
+namespace
+{
+    /// \brief Same association as the SIMD path, which folds b * y + c once per row
+    inline float Evaluate(float a, float b, float c, float x, float y)
+    {
+        return a * x + (b * y + c);
+    }
+
+    inline uint32_t PackColor(float r, float g, float b)
+    {
+        // round to nearest even like _mm256_cvtps_epi32
+        auto channel = [](float v) { return static_cast<uint32_t>(std::nearbyint(std::min(std::max(v, 0.0f), 1.0f) * 255.0f)); };
+        return channel(r) | channel(g) << 8 | channel(b) << 16 | 0xFF000000u;
+    }
+
+    /// \brief Distance above the near plane in clip space, >= 0 is visible
+    inline float NearDistance(const glm::vec4& clip)
+    {
+        return clip.z + clip.w;
+    }
+
+    RasterVertex Lerp(const RasterVertex& a, const RasterVertex& b, float t)
+    {
+        RasterVertex v;
+        v.clip = a.clip + (b.clip - a.clip) * t;
+        v.color = a.color + (b.color - a.color) * t;
+        return v;
+    }
+
+    /// \brief Clamps to [0, limit] before converting: vertices close to w = 0 land far outside
+    /// the int range (or at NaN), where the conversion is undefined. NaN ends up as 0.
+    inline int ClampToPixel(float value, int limit)
+    {
+        return static_cast<int>(std::min(std::max(0.0f, value), static_cast<float>(limit)));
+    }
+}
+
+void SoftwareRasterizer::Resize(int width, int height)
+{
+    this->width = width;
+    this->height = height;
+    stride = (width + 7) & ~7;
+    tilesX = (width + TileSize - 1) / TileSize;
+    tilesY = (height + TileSize - 1) / TileSize;
+    color.assign(static_cast<size_t>(stride) * height, 0);
+    depth.assign(static_cast<size_t>(stride) * height, 1.0f);
+    bins.assign(static_cast<size_t>(tilesX) * tilesY, std::vector<uint32_t>());
+    triangles.clear();
+}
+
+void SoftwareRasterizer::Clear(const glm::vec4& clearColor)
+{
+    std::fill(color.begin(), color.end(), PackColor(clearColor.r, clearColor.g, clearColor.b));
+    std::fill(depth.begin(), depth.end(), 1.0f);
+    triangles.clear();
+}
+
+SoftwareRasterizer::ScreenVertex SoftwareRasterizer::ToScreen(const RasterVertex& v) const
+{
+    ScreenVertex s;
+    s.invW = 1.0f / v.clip.w;
+    s.x = (v.clip.x * s.invW * 0.5f + 0.5f) * width;
+    s.y = (0.5f - v.clip.y * s.invW * 0.5f) * height;
+    s.z = v.clip.z * s.invW * 0.5f + 0.5f;
+    s.colorOverW = v.color * s.invW;
+    return s;
+}
+
+void SoftwareRasterizer::AddPoint(const RasterVertex& a)
+{
+    if (NearDistance(a.clip) < 0.0f || a.clip.w <= 0.0f)
+        return;
+
+    // GL points are screen aligned squares of pointSize pixels
+    ScreenVertex centre = ToScreen(a);
+    const float half = pointSize * 0.5f;
+    ScreenVertex corners[4] = { centre, centre, centre, centre };
+    corners[0].x -= half; corners[0].y -= half;
+    corners[1].x += half; corners[1].y -= half;
+    corners[2].x += half; corners[2].y += half;
+    corners[3].x -= half; corners[3].y += half;
+    EmitQuad(corners[0], corners[1], corners[2], corners[3]);
+}
+
+void SoftwareRasterizer::AddLine(const RasterVertex& a, const RasterVertex& b)
+{
+    float da = NearDistance(a.clip);
+    float db = NearDistance(b.clip);
+    if (da < 0.0f && db < 0.0f)
+        return;
+    RasterVertex p = a, q = b;
+    if (da < 0.0f)
+        p = Lerp(a, b, da / (da - db));
+    else if (db < 0.0f)
+        q = Lerp(a, b, da / (da - db));
+
+    // a quad lineWidth pixels wide around the segment
+    ScreenVertex s = ToScreen(p);
+    ScreenVertex e = ToScreen(q);
+    float dx = e.x - s.x;
+    float dy = e.y - s.y;
+    float length = std::sqrt(dx * dx + dy * dy);
+    if (length < 1e-6f)
+        return;
+    float nx = -dy / length * lineWidth * 0.5f;
+    float ny = dx / length * lineWidth * 0.5f;
+
+    ScreenVertex corners[4] = { s, e, e, s };
+    corners[0].x += nx; corners[0].y += ny;
+    corners[1].x += nx; corners[1].y += ny;
+    corners[2].x -= nx; corners[2].y -= ny;
+    corners[3].x -= nx; corners[3].y -= ny;
+    EmitQuad(corners[0], corners[1], corners[2], corners[3]);
+}
+
+void SoftwareRasterizer::AddTriangle(const RasterVertex& a, const RasterVertex& b, const RasterVertex& c)
+{
+    // Sutherland-Hodgman against the near plane; the other planes are handled by the
+    // pixel bounds and the per-pixel depth range test
+    const RasterVertex* in[3] = { &a, &b, &c };
+    RasterVertex out[4];
+    int count = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        const RasterVertex& current = *in[i];
+        const RasterVertex& next = *in[(i + 1) % 3];
+        float dc = NearDistance(current.clip);
+        float dn = NearDistance(next.clip);
+        if (dc >= 0.0f)
+            out[count++] = current;
+        if ((dc >= 0.0f) != (dn >= 0.0f))
+            out[count++] = Lerp(current, next, dc / (dc - dn));
+    }
+    if (count < 3)
+        return;
+
+    ScreenVertex s0 = ToScreen(out[0]);
+    ScreenVertex s1 = ToScreen(out[1]);
+    ScreenVertex s2 = ToScreen(out[2]);
+    EmitTriangle(s0, s1, s2);
+    if (count == 4)
+        EmitTriangle(s0, s2, ToScreen(out[3]));
+}
+
+void SoftwareRasterizer::EmitQuad(const ScreenVertex& a, const ScreenVertex& b, const ScreenVertex& c, const ScreenVertex& d)
+{
+    EmitTriangle(a, b, c);
+    EmitTriangle(a, c, d);
+}
+
+void SoftwareRasterizer::EmitTriangle(const ScreenVertex& v0, const ScreenVertex& v1, const ScreenVertex& v2)
+{
+    const float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+    if (std::abs(area) < 1e-8f)
+        return;
+
+    ScreenTriangle t;
+    t.minX = ClampToPixel(std::floor(std::min({ v0.x, v1.x, v2.x })), width);
+    t.minY = ClampToPixel(std::floor(std::min({ v0.y, v1.y, v2.y })), height);
+    t.maxX = ClampToPixel(std::ceil(std::max({ v0.x, v1.x, v2.x })), width);
+    t.maxY = ClampToPixel(std::ceil(std::max({ v0.y, v1.y, v2.y })), height);
+    if (t.minX >= t.maxX || t.minY >= t.maxY)
+        return;
+
+    // barycentric weight of each vertex as a plane, from the edge opposite it; dividing by
+    // the signed area makes both windings come out positive inside
+    const ScreenVertex* v[3] = { &v0, &v1, &v2 };
+    const float invArea = 1.0f / area;
+    for (int i = 0; i < 3; i++)
+    {
+        const ScreenVertex& p = *v[(i + 1) % 3];
+        const ScreenVertex& q = *v[(i + 2) % 3];
+        t.edge[i].a = (p.y - q.y) * invArea;
+        t.edge[i].b = (q.x - p.x) * invArea;
+        t.edge[i].c = (p.x * q.y - q.x * p.y) * invArea;
+    }
+
+    auto attribute = [&](float f0, float f1, float f2)
+    {
+        Plane plane;
+        plane.a = t.edge[0].a * f0 + t.edge[1].a * f1 + t.edge[2].a * f2;
+        plane.b = t.edge[0].b * f0 + t.edge[1].b * f1 + t.edge[2].b * f2;
+        plane.c = t.edge[0].c * f0 + t.edge[1].c * f1 + t.edge[2].c * f2;
+        return plane;
+    };
+    t.z = attribute(v0.z, v1.z, v2.z);
+    t.invW = attribute(v0.invW, v1.invW, v2.invW);
+    for (int c = 0; c < 3; c++)
+        t.colorOverW[c] = attribute(v0.colorOverW[c], v1.colorOverW[c], v2.colorOverW[c]);
+
+    triangles.push_back(t);
+}
+
+void SoftwareRasterizer::Flush()
+{
+    PROFILE_SCOPE("Rasterize");
+    if (triangles.empty())
+        return;
+
+    for (std::vector<uint32_t>& bin : bins)
+        bin.clear();
+    for (uint32_t i = 0; i < triangles.size(); i++)
+    {
+        const ScreenTriangle& t = triangles[i];
+        for (int ty = t.minY / TileSize; ty <= (t.maxY - 1) / TileSize; ty++)
+        {
+            for (int tx = t.minX / TileSize; tx <= (t.maxX - 1) / TileSize; tx++)
+                bins[ty * tilesX + tx].push_back(i);
+        }
+    }
+
+    workers.ParallelFor(bins.size(), 1, [&](size_t begin, size_t end)
+    {
+        for (size_t tile = begin; tile < end; tile++)
+            RasterizeTile(static_cast<int>(tile));
+    });
+    triangles.clear();
+}
+
+void SoftwareRasterizer::RasterizeTile(int tile)
+{
+    const int tileX0 = (tile % tilesX) * TileSize;
+    const int tileY0 = (tile / tilesX) * TileSize;
+    const int tileX1 = std::min(tileX0 + TileSize, width);
+    const int tileY1 = std::min(tileY0 + TileSize, height);
+
+    for (uint32_t index : bins[tile])
+    {
+        const ScreenTriangle& t = triangles[index];
+        const int x0 = std::max(t.minX, tileX0) & ~7; // tiles start on multiples of 8
+        const int x1 = std::min(t.maxX, tileX1);
+        const int y0 = std::max(t.minY, tileY0);
+        const int y1 = std::min(t.maxY, tileY1);
+
+        for (int y = y0; y < y1; y++)
+        {
+            const float py = y + 0.5f;
+            uint32_t* colorRow = &color[static_cast<size_t>(y) * stride];
+            float* depthRow = &depth[static_cast<size_t>(y) * stride];
+            int x = x0;
+
+#if defined(__AVX2__)
+            // eight pixels per step: the plane rows are a + b * py + c, then a * px per lane
+            const __m256 laneOffsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+            const __m256 e0a = _mm256_set1_ps(t.edge[0].a), e0r = _mm256_set1_ps(t.edge[0].b * py + t.edge[0].c);
+            const __m256 e1a = _mm256_set1_ps(t.edge[1].a), e1r = _mm256_set1_ps(t.edge[1].b * py + t.edge[1].c);
+            const __m256 e2a = _mm256_set1_ps(t.edge[2].a), e2r = _mm256_set1_ps(t.edge[2].b * py + t.edge[2].c);
+            const __m256 za = _mm256_set1_ps(t.z.a), zr = _mm256_set1_ps(t.z.b * py + t.z.c);
+            const __m256 wa = _mm256_set1_ps(t.invW.a), wr = _mm256_set1_ps(t.invW.b * py + t.invW.c);
+            const __m256 ra = _mm256_set1_ps(t.colorOverW[0].a), rr = _mm256_set1_ps(t.colorOverW[0].b * py + t.colorOverW[0].c);
+            const __m256 ga = _mm256_set1_ps(t.colorOverW[1].a), gr = _mm256_set1_ps(t.colorOverW[1].b * py + t.colorOverW[1].c);
+            const __m256 ba = _mm256_set1_ps(t.colorOverW[2].a), br = _mm256_set1_ps(t.colorOverW[2].b * py + t.colorOverW[2].c);
+            const __m256 zero = _mm256_setzero_ps();
+            const __m256 one = _mm256_set1_ps(1.0f);
+            const __m256 scale = _mm256_set1_ps(255.0f);
+            const __m256 xEnd = _mm256_set1_ps(static_cast<float>(x1));
+
+            for (; x < x1; x += 8)
+            {
+                const __m256 px = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)), laneOffsets);
+                __m256 inside = _mm256_cmp_ps(px, xEnd, _CMP_LT_OQ);
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(e0a, px), e0r), zero, _CMP_GE_OQ));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(e1a, px), e1r), zero, _CMP_GE_OQ));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(e2a, px), e2r), zero, _CMP_GE_OQ));
+                if (_mm256_movemask_ps(inside) == 0)
+                    continue;
+
+                const __m256 z = _mm256_add_ps(_mm256_mul_ps(za, px), zr);
+                const __m256 stored = _mm256_loadu_ps(depthRow + x);
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(z, stored, _CMP_LT_OQ));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(z, zero, _CMP_GE_OQ));
+                if (_mm256_movemask_ps(inside) == 0)
+                    continue;
+                _mm256_storeu_ps(depthRow + x, _mm256_blendv_ps(stored, z, inside));
+
+                const __m256 w = _mm256_div_ps(one, _mm256_add_ps(_mm256_mul_ps(wa, px), wr));
+                auto channel = [&](__m256 a, __m256 r)
+                {
+                    __m256 v = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(a, px), r), w);
+                    v = _mm256_min_ps(_mm256_max_ps(v, zero), one);
+                    return _mm256_cvtps_epi32(_mm256_mul_ps(v, scale));
+                };
+                __m256i packed = _mm256_or_si256(channel(ra, rr), _mm256_slli_epi32(channel(ga, gr), 8));
+                packed = _mm256_or_si256(packed, _mm256_slli_epi32(channel(ba, br), 16));
+                packed = _mm256_or_si256(packed, _mm256_set1_epi32(static_cast<int>(0xFF000000u)));
+                __m256i* target = reinterpret_cast<__m256i*>(colorRow + x);
+                _mm256_storeu_si256(target, _mm256_blendv_epi8(_mm256_loadu_si256(target), packed, _mm256_castps_si256(inside)));
+            }
+#endif
+
+            for (; x < x1; x++)
+            {
+                const float px = x + 0.5f;
+                if (Evaluate(t.edge[0].a, t.edge[0].b, t.edge[0].c, px, py) < 0.0f ||
+                    Evaluate(t.edge[1].a, t.edge[1].b, t.edge[1].c, px, py) < 0.0f ||
+                    Evaluate(t.edge[2].a, t.edge[2].b, t.edge[2].c, px, py) < 0.0f)
+                    continue;
+                const float z = Evaluate(t.z.a, t.z.b, t.z.c, px, py);
+                if (z < 0.0f || z >= depthRow[x])
+                    continue;
+                depthRow[x] = z;
+                const float w = 1.0f / Evaluate(t.invW.a, t.invW.b, t.invW.c, px, py);
+                colorRow[x] = PackColor(Evaluate(t.colorOverW[0].a, t.colorOverW[0].b, t.colorOverW[0].c, px, py) * w,
+                                        Evaluate(t.colorOverW[1].a, t.colorOverW[1].b, t.colorOverW[1].c, px, py) * w,
+                                        Evaluate(t.colorOverW[2].a, t.colorOverW[2].b, t.colorOverW[2].c, px, py) * w);
+            }
+        }
+    }
+}
+
+void SoftwareRasterizer::ReadPixels(std::vector<uint8_t>& rgba) const
+{
+    const size_t rowBytes = static_cast<size_t>(width) * 4;
+    rgba.resize(rowBytes * height);
+    for (int y = 0; y < height; y++)
+        std::memcpy(rgba.data() + y * rowBytes, &color[static_cast<size_t>(y) * stride], rowBytes);
+}
@@ -0,0 +1,92 @@
+﻿#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include "WorkerPool.h"
+
+/// \brief A vertex after the vertex transform, in clip space like gl_Position
+struct RasterVertex
+{
+    glm::vec4 clip;
+    glm::vec3 color;
+};
+
+/// \brief Tiled, multi-threaded CPU rasterizer for points, wide lines and triangles with
+/// perspective-correct colour and a depth test (GL_LESS). Primitives are queued in clip
+/// space, clipped against the near plane and turned into screen triangles; Flush() bins
+/// them into tiles and rasterises every tile on its own thread in submission order, so
+/// the image is the same for any thread count.
+class SoftwareRasterizer
+{
+public:
+    static const int TileSize = 64;
+
+    /// \param threadCount total threads including the caller, 0 uses every hardware thread
+    explicit SoftwareRasterizer(unsigned threadCount = 0) : workers(threadCount) {}
+
+    void Resize(int width, int height);
+    int GetWidth() const { return width; }
+    int GetHeight() const { return height; }
+    WorkerPool& GetWorkers() { return workers; }
+
+    /// \brief Clears colour and depth (to 1) and drops anything queued
+    void Clear(const glm::vec4& color);
+
+    void SetLineWidth(float width) { lineWidth = width; }
+    void SetPointSize(float size) { pointSize = size; }
+
+    void AddPoint(const RasterVertex& a);
+    void AddLine(const RasterVertex& a, const RasterVertex& b);
+    void AddTriangle(const RasterVertex& a, const RasterVertex& b, const RasterVertex& c);
+
+    /// \brief Rasterises everything queued since the last Flush or Clear
+    void Flush();
+
+    /// \brief RGBA, top row first, tightly packed
+    void ReadPixels(std::vector<uint8_t>& rgba) const;
+
+private:
+    struct ScreenVertex
+    {
+        float x, y, z;      // window pixels, y down, z 0..1
+        float invW;
+        glm::vec3 colorOverW;
+    };
+
+    /// \brief a * x + b * y + c over the screen
+    struct Plane
+    {
+        float a, b, c;
+    };
+
+    /// \brief Setup done once per triangle: barycentric edge planes and attribute planes
+    struct ScreenTriangle
+    {
+        Plane edge[3];
+        Plane z;
+        Plane invW;
+        Plane colorOverW[3];
+        int minX, minY, maxX, maxY; // pixel bounds, max exclusive
+    };
+
+    WorkerPool workers;
+    int width = 0;
+    int height = 0;
+    int stride = 0; // pixels per row, padded to 8 so SIMD rows never run into the next one
+    int tilesX = 0;
+    int tilesY = 0;
+    std::vector<uint32_t> color;
+    std::vector<float> depth;
+    float lineWidth = 1.0f;
+    float pointSize = 1.0f;
+
+    std::vector<ScreenTriangle> triangles;
+    std::vector<std::vector<uint32_t>> bins; // triangle indices per tile, in submission order
+
+    ScreenVertex ToScreen(const RasterVertex& v) const;
+    void EmitTriangle(const ScreenVertex& a, const ScreenVertex& b, const ScreenVertex& c);
+    void EmitQuad(const ScreenVertex& a, const ScreenVertex& b, const ScreenVertex& c, const ScreenVertex& d);
+    void RasterizeTile(int tile);
+};
@@ -0,0 +1,25 @@
+#version 330 core
+
+uniform int splatPass;
+
+in vec3 ourColor;
+out vec4 FragColor;
+
+void main()
+{
+    // circular splat inside the square point
+    vec2 p = gl_PointCoord * 2.0 - 1.0;
+    float r2 = dot(p, p);
+    if (r2 > 1.0)
+        discard;
+    if (splatPass == 2)
+    {
+        // weighted towards the centre; SplatResolve.frag divides by the summed weight
+        float weight = 1.0 - r2;
+        FragColor = vec4(ourColor * weight, weight);
+    }
+    else
+    {
+        FragColor = vec4(ourColor, 1.0);
+    }
+}
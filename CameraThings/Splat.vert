@@ -0,0 +1,29 @@
+#version 330 core
+#include "SceneCommon.glsl"
+
+// Points drawn as round splats sized in world units, so near points grow and far ones
+// shrink like real geometry. Blended splatting draws the same points twice: a visibility
+// pass writing depth pushed back by splatDepthOffset, then an accumulation pass that adds
+// up every splat within that distance of the nearest surface.
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aColor;
+
+uniform float splatSize;        // diameter in world units
+uniform float viewportHeight;   // pixels
+uniform float maxPointSize;     // GL_POINT_SIZE_RANGE
+uniform int splatPass;          // 0 opaque, 1 visibility, 2 accumulation
+uniform float splatDepthOffset; // world units
+
+out vec3 ourColor;
+
+void main()
+{
+    vec4 viewPosition = view * model * vec4(aPos, 1.0);
+    gl_Position = projection * viewPosition;
+    // how many pixels splatSize covers at this distance
+    gl_PointSize = clamp(splatSize * projection[1][1] * 0.5 * viewportHeight / gl_Position.w, 1.0, maxPointSize);
+    if (splatPass == 1)
+        gl_Position = projection * vec4(viewPosition.xyz + normalize(viewPosition.xyz) * splatDepthOffset, 1.0);
+    ourColor = aColor;
+}
@@ -0,0 +1,58 @@
+﻿#include "SplatBuffer.h"
+
+#include <iostream>
+#include <glad/glad.h>
+
+namespace
+{
+    unsigned CreateTexture(GLint internalFormat, GLenum format, GLenum type, int width, int height)
+    {
+        unsigned texture = 0;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, nullptr);
+        // read texel for pixel by the resolve pass
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        return texture;
+    }
+}
+
+bool SplatBuffer::Resize(int width, int height)
+{
+    if (framebuffer != 0 && width == this->width && height == this->height)
+        return true;
+
+    Destroy();
+    this->width = width;
+    this->height = height;
+    colorTexture = CreateTexture(GL_RGBA16F, GL_RGBA, GL_FLOAT, width, height);
+    depthTexture = CreateTexture(GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, width, height);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    GLint previous = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, previous);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cout << "ERROR::SPLATBUFFER::INCOMPLETE " << std::hex << status << std::dec << std::endl;
+        Destroy();
+        return false;
+    }
+    return true;
+}
+
+void SplatBuffer::Destroy()
+{
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteTextures(1, &colorTexture);
+    glDeleteTextures(1, &depthTexture);
+    framebuffer = colorTexture = depthTexture = 0;
+}
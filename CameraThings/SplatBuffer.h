@@ -0,0 +1,28 @@
+﻿#pragma once
+
+/// \brief Colour and depth textures the blended splat passes draw into before the result is
+/// resolved onto the frame. Colour is RGBA16F: premultiplied colour sums and the weight sum.
+class SplatBuffer
+{
+public:
+    SplatBuffer() = default;
+    SplatBuffer(const SplatBuffer&) = delete;
+    SplatBuffer& operator=(const SplatBuffer&) = delete;
+    ~SplatBuffer() { Destroy(); }
+
+    /// \brief (Re)creates the textures if the size changed; needs a current context
+    /// \return false if the framebuffer is incomplete
+    bool Resize(int width, int height);
+    void Destroy();
+
+    unsigned GetFramebuffer() const { return framebuffer; }
+    unsigned GetColorTexture() const { return colorTexture; }
+    unsigned GetDepthTexture() const { return depthTexture; }
+
+private:
+    unsigned framebuffer = 0;
+    unsigned colorTexture = 0;
+    unsigned depthTexture = 0;
+    int width = 0;
+    int height = 0;
+};
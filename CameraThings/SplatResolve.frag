@@ -0,0 +1,29 @@
+#version 330 core
+#include "SceneCommon.glsl"
+
+// normalizes the accumulated splats and puts them into the frame at the depth of the
+// nearest splat, so the scene's depth test still applies. The visibility pass pushed that
+// depth back by splatDepthOffset; it is taken off again along the pixel's view ray, or
+// scene geometry just behind the splats would win the depth test and show through.
+uniform sampler2D splatColor;
+uniform sampler2D splatDepth;
+uniform float splatDepthOffset; // world units
+
+in vec2 uv;
+flat in mat4 inverseProjection;
+out vec4 FragColor;
+
+void main()
+{
+    vec4 sum = texture(splatColor, uv);
+    if (sum.a <= 0.0)
+        discard;
+    FragColor = vec4(sum.rgb / sum.a, 1.0);
+
+    vec4 viewPosition = inverseProjection * vec4(uv * 2.0 - 1.0, texture(splatDepth, uv).r * 2.0 - 1.0, 1.0);
+    vec3 surface = viewPosition.xyz / viewPosition.w;
+    float rayLength = length(surface);
+    surface *= max(rayLength - splatDepthOffset, 0.001) / rayLength;
+    vec4 clip = projection * vec4(surface, 1.0);
+    gl_FragDepth = clamp(clip.z / clip.w * 0.5 + 0.5, 0.0, 1.0);
+}
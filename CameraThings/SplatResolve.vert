@@ -0,0 +1,13 @@
+#version 330 core
+#include "SceneCommon.glsl"
+
+// one triangle covering the screen, no vertex data
+out vec2 uv;
+flat out mat4 inverseProjection; // once per triangle instead of once per pixel
+
+void main()
+{
+    uv = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(uv * 2.0 - 1.0, 0.0, 1.0);
+    inverseProjection = inverse(projection);
+}
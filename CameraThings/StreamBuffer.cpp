@@ -0,0 +1,134 @@
+﻿#include "StreamBuffer.h"
+
+#include <cstring>
+#include <iostream>
+#include <glad/glad.h>
+
+#include "GlExtensions.h"
+
+bool StreamBuffer::Create(size_t bytes)
+{
+    Destroy();
+    regionBytes = bytes;
+    const GLsizeiptr totalBytes = static_cast<GLsizeiptr>(regionBytes * RegionCount);
+
+    // a binding point nothing else uses, so the vertex and index bindings stay as they are
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    if (GlExtensions::hasBufferStorage)
+    {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        GlExtensions::BufferStorage(GL_COPY_WRITE_BUFFER, totalBytes, nullptr, flags);
+        mapped = static_cast<uint8_t*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, totalBytes, flags));
+        if (mapped == nullptr)
+            std::cout << "ERROR::STREAMBUFFER::PERSISTENT_MAP_FAILED" << std::endl;
+    }
+    else
+    {
+        glBufferData(GL_COPY_WRITE_BUFFER, totalBytes, nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    if (GlExtensions::hasBufferStorage && mapped == nullptr)
+    {
+        Destroy();
+        return false;
+    }
+    return true;
+}
+
+void StreamBuffer::Destroy()
+{
+    if (buffer == 0)
+        return;
+
+    for (unsigned i = 0; i < RegionCount; i++)
+        WaitForRegion(i);
+    if (mapped)
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        mapped = nullptr;
+    }
+    glDeleteBuffers(1, &buffer);
+    buffer = 0;
+    frame++; // nothing written so far is there any more
+    region = 0;
+    used = 0;
+    regionReady = false;
+}
+
+bool StreamBuffer::Write(const void* data, size_t bytes, size_t alignment, size_t& offset)
+{
+    if (buffer == 0)
+        return false;
+
+    if (!regionReady)
+    {
+        // the first write of a frame: the GPU has to be done with what this region held
+        // RegionCount frames ago, which it almost always is by now
+        WaitForRegion(region);
+        regionReady = true;
+    }
+
+    size_t start = alignment > 1 ? (used + alignment - 1) / alignment * alignment : used;
+    if (start + bytes > regionBytes)
+        return false;
+
+    offset = region * regionBytes + start;
+    if (mapped)
+    {
+        std::memcpy(mapped + offset, data, bytes);
+    }
+    else
+    {
+        // the fence already guarantees the range is free, so no implicit sync is needed
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+        void* target = glMapBufferRange(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(bytes), flags);
+        if (target)
+        {
+            std::memcpy(target, data, bytes);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        if (target == nullptr)
+            return false;
+    }
+    used = start + bytes;
+    return true;
+}
+
+void StreamBuffer::EndFrame()
+{
+    frame++;
+    if (buffer == 0 || !regionReady)
+        return;
+
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    region = (region + 1) % RegionCount;
+    used = 0;
+    regionReady = false;
+}
+
+void StreamBuffer::WaitForRegion(unsigned index)
+{
+    GLsync fence = static_cast<GLsync>(fences[index]);
+    if (fence == nullptr)
+        return;
+
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    if (result == GL_TIMEOUT_EXPIRED)
+    {
+        stalls++;
+        do
+        {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1 ms
+        } while (result == GL_TIMEOUT_EXPIRED);
+    }
+    if (result == GL_WAIT_FAILED)
+        std::cout << "ERROR::STREAMBUFFER::FENCE_WAIT_FAILED" << std::endl;
+    glDeleteSync(fence);
+    fences[index] = nullptr;
+}
@@ -0,0 +1,57 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/// \brief Ring allocator for data rewritten every frame (dynamic meshes, debug lines,
+/// instance data). One buffer holds RegionCount frames; the CPU writes one region while
+/// the GPU may still read the others, and a fence per region tells when it may be reused,
+/// so uploads neither reallocate storage nor wait for the GPU unless it is RegionCount
+/// frames behind. With buffer storage the buffer is mapped once, persistent and coherent;
+/// on plain GL 3.3 each write maps its range unsynchronized instead.
+/// Create and destroy it while the context is current.
+class StreamBuffer
+{
+public:
+    static const unsigned RegionCount = 3;
+
+    StreamBuffer() = default;
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+    ~StreamBuffer() { Destroy(); }
+
+    /// \param regionBytes what one frame may write at most
+    /// \return false if the buffer could not be created or mapped
+    bool Create(size_t regionBytes);
+    /// \brief Waits for the GPU to finish with every region, then deletes the buffer
+    void Destroy();
+
+    /// \brief Copies data into the current frame's region
+    /// \param alignment the offset is a multiple of this, e.g. the vertex stride
+    /// \param offset set to where the data went, in bytes from the start of the buffer
+    /// \return false if the region is full; nothing is written
+    bool Write(const void* data, size_t bytes, size_t alignment, size_t& offset);
+
+    /// \brief Fences the current region after the frame's draws and moves to the next one
+    void EndFrame();
+
+    unsigned GetBuffer() const { return buffer; }
+    size_t GetRegionBytes() const { return regionBytes; }
+    bool IsPersistent() const { return mapped != nullptr; }
+    /// \brief Counts EndFrame (and Destroy) calls; data written before the last one may be gone
+    uint64_t GetFrame() const { return frame; }
+    /// \brief Frames where the CPU had to wait for the GPU before writing
+    size_t GetStalls() const { return stalls; }
+
+private:
+    unsigned buffer = 0;
+    size_t regionBytes = 0;
+    uint8_t* mapped = nullptr; // persistent mapping, null on the fallback path
+    void* fences[RegionCount] = {};
+    unsigned region = 0;
+    size_t used = 0;
+    bool regionReady = false;
+    uint64_t frame = 0;
+    size_t stalls = 0;
+
+    void WaitForRegion(unsigned index);
+};
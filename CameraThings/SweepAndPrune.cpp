@@ -0,0 +1,120 @@
+﻿#include "SweepAndPrune.h"
+
+#include <algorithm>
+
+#include "Profiler.h"
+
+namespace
+{
+    inline uint32_t ObjectOf(uint32_t data) { return data >> 1; }
+    inline bool IsMax(uint32_t data) { return (data & 1u) != 0; }
+
+    inline uint64_t PairKey(uint32_t a, uint32_t b)
+    {
+        return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+    }
+
+    // on equal values mins go first, so touching boxes count as overlapping like in AabbOverlapsAabb
+    inline bool Before(float value, uint32_t data, float otherValue, uint32_t otherData)
+    {
+        return value < otherValue || (value == otherValue && !IsMax(data) && IsMax(otherData));
+    }
+}
+
+void SweepAndPrune::Update(const std::vector<Aabb>& bounds)
+{
+    PROFILE_SCOPE("Broad phase");
+    if (axes[0].size() != bounds.size() * 2)
+    {
+        Rebuild(bounds);
+    }
+    else
+    {
+        for (int axis = 0; axis < 3; axis++)
+            SortAxis(axis, bounds);
+    }
+
+    pairs.clear();
+    pairs.reserve(overlapping.size());
+    for (uint64_t key : overlapping)
+        pairs.push_back({ static_cast<uint32_t>(key >> 32), static_cast<uint32_t>(key & 0xffffffffu) });
+    SortPairs();
+}
+
+/// \brief Sorts every axis from scratch and finds the starting overlaps with one sweep along x
+void SweepAndPrune::Rebuild(const std::vector<Aabb>& bounds)
+{
+    overlapping.clear();
+    for (int axis = 0; axis < 3; axis++)
+    {
+        std::vector<Endpoint>& list = axes[axis];
+        list.resize(bounds.size() * 2);
+        for (uint32_t i = 0; i < bounds.size(); i++)
+        {
+            list[2 * i] = { bounds[i].min[axis], i << 1 };
+            list[2 * i + 1] = { bounds[i].max[axis], (i << 1) | 1u };
+        }
+        std::sort(list.begin(), list.end(), [](const Endpoint& l, const Endpoint& r)
+        {
+            return Before(l.value, l.data, r.value, r.data);
+        });
+    }
+
+    std::vector<uint32_t> active;
+    for (const Endpoint& endpoint : axes[0])
+    {
+        uint32_t object = ObjectOf(endpoint.data);
+        if (IsMax(endpoint.data))
+        {
+            active.erase(std::find(active.begin(), active.end(), object));
+            continue;
+        }
+        for (uint32_t other : active)
+        {
+            if (Collision::AabbOverlapsAabb(bounds[object], bounds[other]))
+                overlapping.insert(PairKey(object, other));
+        }
+        active.push_back(object);
+    }
+}
+
+/// \brief Refreshes one axis' endpoint values and restores the order with insertion sort,
+/// updating the overlap set for every min/max swap
+void SweepAndPrune::SortAxis(int axis, const std::vector<Aabb>& bounds)
+{
+    std::vector<Endpoint>& list = axes[axis];
+    for (Endpoint& endpoint : list)
+    {
+        const Aabb& box = bounds[ObjectOf(endpoint.data)];
+        endpoint.value = IsMax(endpoint.data) ? box.max[axis] : box.min[axis];
+    }
+
+    for (size_t i = 1; i < list.size(); i++)
+    {
+        Endpoint key = list[i];
+        size_t j = i;
+        while (j > 0 && Before(key.value, key.data, list[j - 1].value, list[j - 1].data))
+        {
+            const Endpoint& other = list[j - 1];
+            uint32_t a = ObjectOf(key.data);
+            uint32_t b = ObjectOf(other.data);
+            if (a != b)
+            {
+                if (!IsMax(key.data) && IsMax(other.data))
+                {
+                    // a min moved below a max: the boxes may now overlap
+                    if (Collision::AabbOverlapsAabb(bounds[a], bounds[b]))
+                        overlapping.insert(PairKey(a, b));
+                }
+                else if (IsMax(key.data) && !IsMax(other.data))
+                {
+                    // a max moved below a min: separated on this axis
+                    overlapping.erase(PairKey(a, b));
+                }
+            }
+            list[j] = other;
+            j--;
+        }
+        list[j] = key;
+    }
+}
@@ -0,0 +1,30 @@
+﻿#pragma once
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+#include "BroadPhase.h"
+
+/// \brief Incremental sweep and prune. Keeps the box endpoints of every object sorted along
+/// each axis and repairs the order with insertion sort every step. Because objects move
+/// little between frames this is close to linear, and each swap of a min past a max (or
+/// back) adds or removes exactly one pair, so the overlap set is never rebuilt.
+class SweepAndPrune : public BroadPhase
+{
+public:
+    void Update(const std::vector<Aabb>& bounds) override;
+    const char* GetName() const override { return "sweep and prune"; }
+
+private:
+    struct Endpoint
+    {
+        float value;
+        uint32_t data; // object index << 1 | 1 for a max endpoint
+    };
+
+    std::vector<Endpoint> axes[3];
+    std::unordered_set<uint64_t> overlapping;
+
+    void Rebuild(const std::vector<Aabb>& bounds);
+    void SortAxis(int axis, const std::vector<Aabb>& bounds);
+};
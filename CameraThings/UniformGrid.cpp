@@ -0,0 +1,94 @@
+﻿#include "UniformGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Profiler.h"
+
+namespace
+{
+    const int64_t CoordinateBias = 1 << 20; // 21 bits per axis in the packed cell key
+
+    inline int64_t CellCoordinate(float value, float invCellSize)
+    {
+        return static_cast<int64_t>(std::floor(value * invCellSize));
+    }
+
+    inline uint64_t CellKey(int64_t x, int64_t y, int64_t z)
+    {
+        const uint64_t mask = (1u << 21) - 1;
+        return (uint64_t(x + CoordinateBias) & mask) << 42
+             | (uint64_t(y + CoordinateBias) & mask) << 21
+             | (uint64_t(z + CoordinateBias) & mask);
+    }
+}
+
+void UniformGrid::Update(const std::vector<Aabb>& bounds)
+{
+    PROFILE_SCOPE("Broad phase");
+    pairs.clear();
+    entries.clear();
+    if (bounds.empty())
+        return;
+
+    float cellSize = fixedCellSize;
+    if (cellSize <= 0.0f)
+    {
+        float total = 0.0f;
+        for (const Aabb& box : bounds)
+        {
+            glm::vec3 extent = box.max - box.min;
+            total += std::max(extent.x, std::max(extent.y, extent.z));
+        }
+        cellSize = std::max(2.0f * total / bounds.size(), 1e-3f);
+    }
+    const float invCellSize = 1.0f / cellSize;
+
+    for (uint32_t i = 0; i < bounds.size(); i++)
+    {
+        const Aabb& box = bounds[i];
+        int64_t x0 = CellCoordinate(box.min.x, invCellSize), x1 = CellCoordinate(box.max.x, invCellSize);
+        int64_t y0 = CellCoordinate(box.min.y, invCellSize), y1 = CellCoordinate(box.max.y, invCellSize);
+        int64_t z0 = CellCoordinate(box.min.z, invCellSize), z1 = CellCoordinate(box.max.z, invCellSize);
+        for (int64_t x = x0; x <= x1; x++)
+            for (int64_t y = y0; y <= y1; y++)
+                for (int64_t z = z0; z <= z1; z++)
+                    entries.push_back({ CellKey(x, y, z), i });
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const CellEntry& l, const CellEntry& r)
+    {
+        return l.cell != r.cell ? l.cell < r.cell : l.object < r.object;
+    });
+
+    size_t start = 0;
+    while (start < entries.size())
+    {
+        size_t end = start + 1;
+        while (end < entries.size() && entries[end].cell == entries[start].cell)
+            end++;
+
+        for (size_t i = start; i < end; i++)
+        {
+            uint32_t a = entries[i].object;
+            for (size_t j = i + 1; j < end; j++)
+            {
+                uint32_t b = entries[j].object;
+                if (!Collision::AabbOverlapsAabb(bounds[a], bounds[b]))
+                    continue;
+
+                // only the cell holding the overlap's min corner reports the pair
+                glm::vec3 corner(std::max(bounds[a].min.x, bounds[b].min.x),
+                                 std::max(bounds[a].min.y, bounds[b].min.y),
+                                 std::max(bounds[a].min.z, bounds[b].min.z));
+                uint64_t owner = CellKey(CellCoordinate(corner.x, invCellSize),
+                                         CellCoordinate(corner.y, invCellSize),
+                                         CellCoordinate(corner.z, invCellSize));
+                if (owner == entries[start].cell)
+                    pairs.push_back({ a, b });
+            }
+        }
+        start = end;
+    }
+    SortPairs();
+}
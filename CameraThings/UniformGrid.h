@@ -0,0 +1,28 @@
+﻿#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "BroadPhase.h"
+
+/// \brief Uniform grid broad phase, rebuilt from scratch each step. Each object is binned
+/// into every cell its box touches, and each pair is reported only by the cell holding
+/// the min corner of the two boxes' overlap, so no duplicate removal is needed.
+class UniformGrid : public BroadPhase
+{
+public:
+    /// \param cellSize edge length of a cell, 0 picks twice the average box size each update
+    explicit UniformGrid(float cellSize = 0.0f) : fixedCellSize(cellSize) {}
+
+    void Update(const std::vector<Aabb>& bounds) override;
+    const char* GetName() const override { return "uniform grid"; }
+
+private:
+    struct CellEntry
+    {
+        uint64_t cell;
+        uint32_t object;
+    };
+
+    float fixedCellSize;
+    std::vector<CellEntry> entries;
+};
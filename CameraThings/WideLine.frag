@@ -0,0 +1,21 @@
+#version 330 core
+
+uniform float lineWidth;
+uniform int lineJoin;
+
+noperspective in vec3 lineCoord;
+in vec3 ourColor;
+out vec4 FragColor;
+
+void main()
+{
+    if (lineJoin == 1)
+    {
+        // round caps: keep what is within half the width of the segment
+        float beyond = lineCoord.x - clamp(lineCoord.x, 0.0, lineCoord.z);
+        float halfWidth = lineWidth * 0.5;
+        if (beyond * beyond + lineCoord.y * lineCoord.y > halfWidth * halfWidth)
+            discard;
+    }
+    FragColor = vec4(ourColor, 1.0);
+}
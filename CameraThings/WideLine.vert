@@ -0,0 +1,135 @@
+#version 330 core
+#include "SceneCommon.glsl"
+
+// Wide lines without glLineWidth or a geometry shader: every instance is one segment of a
+// line strip, drawn as 6 vertices forming a screen-space quad lineWidth pixels wide. The
+// strip's vertices come from a buffer texture, so the neighbours a join needs are at hand.
+// Behind-the-camera segments are dropped rather than clipped.
+
+#ifdef CURVE_BATCH
+uniform usamplerBuffer lineVertices; // per point: position bits, curve index (GlBackend CurveVertex)
+uniform samplerBuffer curveData;     // 5 texels per curve: transform columns, colour
+#else
+uniform samplerBuffer lineVertices;  // 6 floats per vertex: position, colour
+#endif
+uniform int lineFirst;     // strip vertices lineFirst..lineLast, instance i is the segment from lineFirst + i
+uniform int lineLast;
+uniform float lineWidth;   // pixels
+uniform int lineJoin;      // 0 miter, 1 round
+uniform vec2 viewportSize;
+
+noperspective out vec3 lineCoord; // pixels along the segment from its start, across it, segment length
+out vec3 ourColor;
+
+const int ends[6] = int[6](0, 0, 1, 1, 0, 1);
+const float sides[6] = float[6](-1.0, 1.0, -1.0, -1.0, 1.0, 1.0);
+
+#ifdef CURVE_BATCH
+uvec4 Fetch(int i)
+{
+    return texelFetch(lineVertices, i);
+}
+
+// the batch holds many strips back to back, a segment must not bridge two curves
+bool SameStrip(int i, int j)
+{
+    return i >= lineFirst && i <= lineLast && Fetch(i).w == Fetch(j).w;
+}
+
+vec3 Position(int i)
+{
+    return uintBitsToFloat(Fetch(i).xyz);
+}
+#else
+vec3 Fetch3(int i, int offset)
+{
+    int base = i * 6 + offset;
+    return vec3(texelFetch(lineVertices, base).r, texelFetch(lineVertices, base + 1).r, texelFetch(lineVertices, base + 2).r);
+}
+
+bool SameStrip(int i, int j)
+{
+    return i >= lineFirst && i <= lineLast;
+}
+
+vec3 Position(int i)
+{
+    return Fetch3(i, 0);
+}
+#endif
+
+vec2 ToScreen(vec4 clip)
+{
+    return clip.xy / clip.w * 0.5 * viewportSize;
+}
+
+void main()
+{
+    int a = lineFirst + gl_InstanceID;
+    int b = a + 1;
+    int end = ends[gl_VertexID];
+    float side = sides[gl_VertexID];
+    lineCoord = vec3(0.0);
+    ourColor = vec3(0.0);
+    if (!SameStrip(b, a))
+    {
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0); // outside the clip volume
+        return;
+    }
+
+#ifdef CURVE_BATCH
+    int curve = int(Fetch(a).w) * 5;
+    mat4 toClip = viewProjection * model * mat4(texelFetch(curveData, curve), texelFetch(curveData, curve + 1),
+                                                texelFetch(curveData, curve + 2), texelFetch(curveData, curve + 3));
+    ourColor = texelFetch(curveData, curve + 4).rgb;
+#else
+    mat4 toClip = viewProjection * model;
+    ourColor = Fetch3(end == 0 ? a : b, 3);
+#endif
+
+    vec4 clipA = toClip * vec4(Position(a), 1.0);
+    vec4 clipB = toClip * vec4(Position(b), 1.0);
+    if (clipA.w <= 0.0 || clipB.w <= 0.0)
+    {
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        return;
+    }
+    vec2 screenA = ToScreen(clipA);
+    vec2 screenB = ToScreen(clipB);
+    float len = length(screenB - screenA);
+    vec2 dir = len > 1e-4 ? (screenB - screenA) / len : vec2(1.0, 0.0);
+    vec2 normal = vec2(-dir.y, dir.x);
+    float halfWidth = lineWidth * 0.5;
+
+    vec2 offset = normal * side * halfWidth;
+    float along = end == 0 ? 0.0 : len;
+    if (lineJoin == 1)
+    {
+        // round: each segment gets round caps (cut out in WideLine.frag), and the caps of
+        // neighbouring segments overlap into round joins
+        offset += dir * (end == 0 ? -halfWidth : halfWidth);
+        along += end == 0 ? -halfWidth : halfWidth;
+    }
+    else
+    {
+        // miter: both segments of a join end on the same line through the shared vertex
+        int neighbour = end == 0 ? a - 1 : b + 1;
+        if (SameStrip(neighbour, a))
+        {
+            vec4 clipN = toClip * vec4(Position(neighbour), 1.0);
+            vec2 other = end == 0 ? screenA - ToScreen(clipN) : ToScreen(clipN) - screenB;
+            vec2 sum = length(other) > 1e-4 ? normalize(other) + dir : vec2(0.0);
+            if (clipN.w > 0.0 && length(sum) > 1e-3)
+            {
+                vec2 tangent = normalize(sum);
+                vec2 miter = vec2(-tangent.y, tangent.x);
+                // longer the sharper the join, limited so near reversals do not spike
+                offset = miter * side * halfWidth / max(dot(miter, normal), 0.25);
+            }
+        }
+    }
+
+    lineCoord = vec3(along, side * halfWidth, len);
+    vec4 clip = end == 0 ? clipA : clipB;
+    gl_Position = vec4(clip.xy + offset / (0.5 * viewportSize) * clip.w, clip.zw);
+}
@@ -0,0 +1,95 @@
+﻿#include "WorkerPool.h"
+
+#include <algorithm>
+
+#include "Profiler.h"
+
+WorkerPool::WorkerPool(unsigned threadCount)
+{
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    this->threadCount = threadCount;
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+void WorkerPool::Start()
+{
+    for (unsigned i = 1; i < threadCount; i++)
+        threads.emplace_back(&WorkerPool::WorkerLoop, this);
+}
+
+void WorkerPool::ParallelFor(size_t count, size_t minChunk, const std::function<void(size_t, size_t)>& function)
+{
+    if (count == 0)
+        return;
+    minChunk = std::max<size_t>(minChunk, 1);
+    if (threadCount <= 1 || count <= minChunk)
+    {
+        function(0, count);
+        return;
+    }
+    if (threads.empty())
+        Start();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // a few chunks per thread so uneven chunks still balance out
+        size_t chunks = size_t(threadCount) * 4;
+        job = &function;
+        jobCount = count;
+        chunkSize = std::max(minChunk, (count + chunks - 1) / chunks);
+        nextIndex = 0;
+        busyWorkers = static_cast<unsigned>(threads.size());
+        generation++;
+    }
+    wake.notify_all();
+
+    RunChunks();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return busyWorkers == 0; });
+    job = nullptr;
+}
+
+void WorkerPool::WorkerLoop()
+{
+    uint64_t seen = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping)
+                return;
+            seen = generation;
+        }
+
+        RunChunks();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busyWorkers == 0)
+            done.notify_one();
+    }
+}
+
+void WorkerPool::RunChunks()
+{
+    PROFILE_SCOPE("Chunks");
+    for (;;)
+    {
+        size_t begin = nextIndex.fetch_add(chunkSize);
+        if (begin >= jobCount)
+            return;
+        (*job)(begin, std::min(begin + chunkSize, jobCount));
+    }
+}
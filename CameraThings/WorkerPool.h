@@ -0,0 +1,47 @@
+﻿#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// \brief Persistent worker threads for data parallel loops. Threads are started on the
+/// first ParallelFor, so an unused pool costs nothing.
+class WorkerPool
+{
+public:
+    /// \param threadCount total threads including the caller, 0 uses every hardware thread
+    explicit WorkerPool(unsigned threadCount = 0);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /// \brief Splits [0, count) into chunks of at least minChunk and runs function(begin, end)
+    /// on the workers and the calling thread. Returns when every chunk is done.
+    void ParallelFor(size_t count, size_t minChunk, const std::function<void(size_t, size_t)>& function);
+
+    unsigned GetThreadCount() const { return threadCount; }
+
+private:
+    unsigned threadCount;
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    uint64_t generation = 0;
+    unsigned busyWorkers = 0;
+    bool stopping = false;
+
+    const std::function<void(size_t, size_t)>* job = nullptr;
+    size_t jobCount = 0;
+    size_t chunkSize = 1;
+    std::atomic<size_t> nextIndex{0};
+
+    void Start();
+    void WorkerLoop();
+    void RunChunks();
+};